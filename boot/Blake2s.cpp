@@ -0,0 +1,117 @@
+#include "Blake2s.h"
+#include <cstring>
+
+namespace {
+constexpr uint32_t initVector[8] = {0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+                                    0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U};
+
+constexpr uint8_t sigma[10][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15}, {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4}, {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13}, {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11}, {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5}, {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0}};
+
+inline uint32_t Rotr(uint32_t x, unsigned n)
+{
+    return (x >> n) | (x << (32U - n));
+}
+
+inline void Mix(uint32_t* v, size_t a, size_t b, size_t c, size_t d, uint32_t x, uint32_t y)
+{
+    v[a] = v[a] + v[b] + x;
+    v[d] = Rotr(v[d] ^ v[a], 16U);
+    v[c] = v[c] + v[d];
+    v[b] = Rotr(v[b] ^ v[c], 12U);
+    v[a] = v[a] + v[b] + y;
+    v[d] = Rotr(v[d] ^ v[a], 8U);
+    v[c] = v[c] + v[d];
+    v[b] = Rotr(v[b] ^ v[c], 7U);
+}
+} // namespace
+
+void Blake2s::Start()
+{
+    std::memcpy(state_, initVector, sizeof(state_));
+    /* Parameter block: digest length, no key, fanout and depth 1 */
+    state_[0] ^= 0x01010000U ^ static_cast<uint32_t>(digestSize);
+    counter_[0] = 0U;
+    counter_[1] = 0U;
+    bufferLength_ = 0U;
+}
+
+void Blake2s::Compress(const uint8_t* block, bool last)
+{
+    uint32_t m[16];
+    uint32_t v[16];
+
+    /* Message words are little-endian, as is the target */
+    std::memcpy(m, block, sizeof(m));
+    std::memcpy(&v[0], state_, sizeof(state_));
+    std::memcpy(&v[8], initVector, sizeof(initVector));
+    v[12] ^= counter_[0];
+    v[13] ^= counter_[1];
+    if (last)
+    {
+        v[14] = ~v[14];
+    }
+
+    for (const auto& s : sigma)
+    {
+        Mix(v, 0U, 4U, 8U, 12U, m[s[0]], m[s[1]]);
+        Mix(v, 1U, 5U, 9U, 13U, m[s[2]], m[s[3]]);
+        Mix(v, 2U, 6U, 10U, 14U, m[s[4]], m[s[5]]);
+        Mix(v, 3U, 7U, 11U, 15U, m[s[6]], m[s[7]]);
+        Mix(v, 0U, 5U, 10U, 15U, m[s[8]], m[s[9]]);
+        Mix(v, 1U, 6U, 11U, 12U, m[s[10]], m[s[11]]);
+        Mix(v, 2U, 7U, 8U, 13U, m[s[12]], m[s[13]]);
+        Mix(v, 3U, 4U, 9U, 14U, m[s[14]], m[s[15]]);
+    }
+
+    for (size_t i = 0U; i < 8U; i++)
+    {
+        state_[i] ^= v[i] ^ v[i + 8U];
+    }
+}
+
+void Blake2s::Update(const uint8_t* data, size_t size)
+{
+    while (size > 0U)
+    {
+        /* A full buffer is only compressed once it is known not to be the last block */
+        if (bufferLength_ == blockSize)
+        {
+            counter_[0] += blockSize;
+            counter_[1] += (counter_[0] < blockSize) ? 1U : 0U;
+            Compress(buffer_, false);
+            bufferLength_ = 0U;
+        }
+
+        /* Whole blocks straight from the input while more data follows them */
+        while ((bufferLength_ == 0U) && (size > blockSize))
+        {
+            counter_[0] += blockSize;
+            counter_[1] += (counter_[0] < blockSize) ? 1U : 0U;
+            Compress(data, false);
+            data += blockSize;
+            size -= blockSize;
+        }
+
+        size_t chunk = blockSize - bufferLength_;
+        chunk = (chunk < size) ? chunk : size;
+        std::memcpy(&buffer_[bufferLength_], data, chunk);
+        bufferLength_ += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void Blake2s::Finish(uint8_t* digest)
+{
+    counter_[0] += static_cast<uint32_t>(bufferLength_);
+    counter_[1] += (counter_[0] < bufferLength_) ? 1U : 0U;
+    std::memset(&buffer_[bufferLength_], 0, blockSize - bufferLength_);
+    Compress(buffer_, true);
+
+    std::memcpy(digest, state_, digestSize);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* BLAKE2s-256 without key (RFC 7693). The last block has to be compressed with the final flag, so a
+   full block is kept back until more data arrives or Finish is called. */
+class Blake2s
+{
+  public:
+    static constexpr size_t digestSize = 32U;
+
+    void Start();
+    void Update(const uint8_t* data, size_t size);
+    void Finish(uint8_t* digest);
+
+  private:
+    static constexpr size_t blockSize = 64U;
+
+    uint32_t state_[8];
+    uint32_t counter_[2];
+    uint8_t buffer_[blockSize];
+    size_t bufferLength_;
+
+    void Compress(const uint8_t* block, bool last);
+};
@@ -0,0 +1,73 @@
+#include "BootArena.h"
+#include "BootConfig.h"
+
+alignas(8) static uint8_t arenaStorage[BootConfig::arenaSize];
+
+size_t BootArena::offset = 0U;
+BootArena::Phase BootArena::phase = BootArena::Phase::receive;
+size_t BootArena::lastStart = 0U;
+size_t BootArena::lastHighWaterMark = 0U;
+size_t BootArena::highWaterMarks[static_cast<size_t>(Phase::numPhases)] = {};
+
+BootArena::Scope::Scope(Phase phase) : mark(BootArena::offset), previousPhase(BootArena::phase)
+{
+    BootArena::phase = phase;
+}
+
+BootArena::Scope::~Scope()
+{
+    BootArena::offset = mark;
+    BootArena::phase = previousPhase;
+}
+
+void* BootArena::Allocate(size_t size)
+{
+    size_t start = (offset + alignment - 1U) & ~(alignment - 1U);
+
+    if ((start > sizeof(arenaStorage)) || (size > sizeof(arenaStorage) - start))
+    {
+        return nullptr;
+    }
+
+    offset = start + size;
+
+    size_t& highWaterMark = highWaterMarks[static_cast<size_t>(phase)];
+    lastStart = start;
+    lastHighWaterMark = highWaterMark;
+    if (offset > highWaterMark)
+    {
+        highWaterMark = offset;
+    }
+
+    return &arenaStorage[start];
+}
+
+void BootArena::Trim(void* block, size_t used)
+{
+    if ((block != &arenaStorage[lastStart]) || (lastStart + used > offset))
+    {
+        return;
+    }
+
+    offset = lastStart + used;
+
+    size_t& highWaterMark = highWaterMarks[static_cast<size_t>(phase)];
+    highWaterMark = (offset > lastHighWaterMark) ? offset : lastHighWaterMark;
+}
+
+size_t BootArena::GetHighWaterMark()
+{
+    size_t highWaterMark = 0U;
+
+    for (size_t phaseMark : highWaterMarks)
+    {
+        highWaterMark = (phaseMark > highWaterMark) ? phaseMark : highWaterMark;
+    }
+
+    return highWaterMark;
+}
+
+size_t BootArena::GetHighWaterMark(Phase phase)
+{
+    return highWaterMarks[static_cast<size_t>(phase)];
+}
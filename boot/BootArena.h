@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* Working memory for the bootloader stages that never run at the same time. Allocation moves an
+   offset forward and a Scope hands everything allocated within it back at once when it ends. The
+   peak use of every phase is kept, so BootConfig::arenaSize can be sized from measurements. */
+class BootArena
+{
+  public:
+    enum class Phase
+    {
+        receive,
+        decompress,
+        verify,
+        numPhases
+    };
+
+    class Scope
+    {
+      public:
+        explicit Scope(Phase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+      private:
+        size_t mark;
+        Phase previousPhase;
+    };
+
+    /* nullptr when the arena is exhausted */
+    static void* Allocate(size_t size);
+    /* The last allocation turned out to need only used bytes, its phase reports that instead of the size
+       reserved. The mbedtls heap is taken whole and trimmed to its real peak after the check. */
+    static void Trim(void* block, size_t used);
+    static size_t GetHighWaterMark();
+    static size_t GetHighWaterMark(Phase phase);
+
+  private:
+    static constexpr size_t alignment = 8U;
+
+    static size_t offset;
+    static Phase phase;
+    static size_t lastStart;
+    static size_t lastHighWaterMark;
+    static size_t highWaterMarks[static_cast<size_t>(Phase::numPhases)];
+};
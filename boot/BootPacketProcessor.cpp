@@ -13,7 +13,7 @@ void BootPacketProcessor::OnPacketReceived(const beecom::Packet& packet, bool cr
     size_t index = static_cast<size_t>(packet.header.type);
     if (index < bootloader_.packetHandlers.size() && bootloader_.packetHandlers[index] != nullptr)
     {
-        bootloader_.HandleValidPacket(packet);
+        bootloader_.QueuePacket(packet);
     }
     else
     {
@@ -3,13 +3,45 @@
 #include "Bootloader.h"
 #include "BootConfig.h"
 #include "AppJumper.h"
+#include "HardwareCrc.h"
+#include "CycleCounter.h"
+#include "FlashKernels.h"
+#include "BootArena.h"
 #if (ECC_FIRMWARE_VALIDATION == 1)
 #include "SecureBootECC.h"
+using SecureBootBackend = SecureBootECC;
 #elif (RSA_FIRMWARE_VALIDATION == 1)
 #include "SecureBootRSA.h"
+using SecureBootBackend = SecureBootRSA;
+#elif (ED25519_FIRMWARE_VALIDATION == 1)
+#include "SecureBootEd25519.h"
+using SecureBootBackend = SecureBootEd25519;
 #endif
 
 constexpr uint32_t applicationValidFlag = 0x5A5A5A5AU;
+constexpr uint32_t validationRecordMarker = 0xC3A5965AU;
+constexpr uint32_t manifestMarker = 0x96C35AA5U;
+
+/* Optional transfer features reported in the configureWindow response */
+constexpr uint8_t capabilityCompressedData = 0x01U;
+constexpr uint8_t capabilityFill = 0x02U;
+
+/* Algorithms of getRangeDigest */
+constexpr uint8_t rangeDigestCrc32 = 0x00U;
+constexpr uint8_t rangeDigestSha256 = 0x01U;
+
+/* Upper bound of application sectors reported by getSectorDigests */
+constexpr size_t maxSectorDigests = 16U;
+
+static_assert(BootConfig::validationKeyOtpBlock < FlashMapping::otpBlockCount, "No such OTP block");
+
+static void StoreBigEndian(uint8_t* destination, uint32_t value)
+{
+    destination[0] = static_cast<uint8_t>(value >> 24U);
+    destination[1] = static_cast<uint8_t>(value >> 16U);
+    destination[2] = static_cast<uint8_t>(value >> 8U);
+    destination[3] = static_cast<uint8_t>(value);
+}
 
 Bootloader::Bootloader(beecom::BeeCOM& beecom, FlashManager& flashManager) :
     beecom_(beecom), flashManager_(flashManager)
@@ -21,10 +53,63 @@ Bootloader::Bootloader(beecom::BeeCOM& beecom, FlashManager& flashManager) :
         nullptr,
         &Bootloader::HandleValidateSignature,
         &Bootloader::HandleReadDataRequest,
-        &Bootloader::HandleReadDataRequest};
+        &Bootloader::HandleReadDataRequest,
+        &Bootloader::HandleConfigureWindow,
+        &Bootloader::HandleFlashDataWindowed,
+        &Bootloader::HandleSetBaudRate,
+        &Bootloader::HandleConfirmBaudRate,
+        &Bootloader::HandleFlashDataWindowed,
+        &Bootloader::HandleDeltaStart,
+        &Bootloader::HandleDeltaData,
+        &Bootloader::HandleFlashDataWindowed,
+        &Bootloader::HandleGetSectorDigests,
+        &Bootloader::HandleGetRangeDigest,
+        &Bootloader::HandleFlashManifest};
     beecom_.SetObserver(&packetProcessor);
 }
 
+void Bootloader::SetTransportHooks(const TransportHooks& hooks)
+{
+    transportHooks_ = hooks;
+}
+
+uint32_t Bootloader::GetValidationCycles() const
+{
+    return validationCycles_;
+}
+
+void Bootloader::QueuePacket(const beecom::Packet& packet)
+{
+    if (packetPool_.IsFull())
+    {
+        /* No free slot, the oldest packet has to be handled before the new one is accepted */
+        ProcessPendingPacket();
+    }
+
+    if (!packetPool_.Store(packet))
+    {
+        /* Does not fit into a slot, handle it in place once everything queued before it is done */
+        while (ProcessPendingPacket())
+        {
+        }
+        HandleValidPacket(packet);
+    }
+}
+
+bool Bootloader::ProcessPendingPacket()
+{
+    const beecom::Packet* packet = packetPool_.Front();
+
+    if (packet == nullptr)
+    {
+        return false;
+    }
+
+    HandleValidPacket(*packet);
+    packetPool_.Release();
+    return true;
+}
+
 void Bootloader::HandleValidPacket(const beecom::Packet& packet)
 {
     size_t index = static_cast<size_t>(packet.header.type);
@@ -52,6 +137,24 @@ void Bootloader::SendResponse(packetType type, const uint8_t* data, size_t dataS
     beecom_.Send(static_cast<uint8_t>(type), data, dataSize);
 }
 
+void Bootloader::FlushTransport()
+{
+    if (transportHooks_.flush != nullptr)
+    {
+        transportHooks_.flush();
+    }
+}
+
+void Bootloader::CheckBaudRateProbe()
+{
+    if ((fallbackBaudRate_ != 0U) && (HAL_GetTick() - baudProbeStart_ > BootConfig::baudRateProbeTimeoutMs))
+    {
+        /* The host never reached us at the new rate, go back to the one that worked */
+        transportHooks_.setBaudRate(fallbackBaudRate_);
+        fallbackBaudRate_ = 0U;
+    }
+}
+
 void Bootloader::SendNackResponse(packetType type)
 {
     const uint8_t nackValue = 0xAAU;
@@ -66,15 +169,36 @@ void Bootloader::SendAckResponse(packetType type)
     SendResponse(type, &ackValue, sizeof(ackValue));
 }
 
-uint32_t Bootloader::ExtractAddress(const beecom::Packet& packet)
+void Bootloader::SendWindowResponse(packetType type, bool ack)
+{
+    uint16_t base = transferWindow_.GetBase();
+    uint32_t mask = transferWindow_.GetReceivedMask();
+    const uint8_t response[] = {
+        ack ? static_cast<uint8_t>(0x55U) : static_cast<uint8_t>(0xAAU),
+        static_cast<uint8_t>(base >> 8U),
+        static_cast<uint8_t>(base),
+        static_cast<uint8_t>(mask >> 24U),
+        static_cast<uint8_t>(mask >> 16U),
+        static_cast<uint8_t>(mask >> 8U),
+        static_cast<uint8_t>(mask)};
+
+    SendResponse(type, response, sizeof(response));
+}
+
+uint32_t Bootloader::ExtractAddress(const beecom::Packet& packet, size_t offset)
 {
-    uint32_t address = (static_cast<uint32_t>(packet.payload[0]) << 24U)
-        | (static_cast<uint32_t>(packet.payload[1]) << 16U) | (static_cast<uint32_t>(packet.payload[2]) << 8U)
-        | static_cast<uint32_t>(packet.payload[3]);
+    const uint8_t* field = packet.payload + offset;
+    uint32_t address = (static_cast<uint32_t>(field[0]) << 24U) | (static_cast<uint32_t>(field[1]) << 16U)
+        | (static_cast<uint32_t>(field[2]) << 8U) | static_cast<uint32_t>(field[3]);
 
     return address;
 }
 
+uint16_t Bootloader::ExtractSequence(const beecom::Packet& packet)
+{
+    return static_cast<uint16_t>((static_cast<uint16_t>(packet.payload[0]) << 8U) | packet.payload[1]);
+}
+
 inline bool Bootloader::IsPresentFlagSet()
 {
     return FlashMapping::GetMetaData()->appPresentFlag == applicationValidFlag;
@@ -85,15 +209,67 @@ inline bool Bootloader::IsJumpToBootFlagSet()
     return *FlashMapping::GetJumpToBootFlag() == FlashMapping::bootFlagValue;
 }
 
+bool Bootloader::HashProgrammedData(uint32_t address, const uint8_t* data, size_t size)
+{
+    /* The metadata is written last and is not part of the signed image */
+    bool isMetaData = (address >= FlashMapping::appMetaDataAddress)
+        && (address < FlashMapping::appMetaDataAddress + sizeof(FlashMapping::MetaData));
+
+    if (isMetaData)
+    {
+        return true;
+    }
+
+    imageHash_.Add(address, data, size);
+    manifest_.Add(address, size);
+    return VerifyManifestBlocks();
+}
+
+bool Bootloader::VerifyManifestBlocks()
+{
+    if (!manifest_.HasPendingBlocks())
+    {
+        return true;
+    }
+
+    /* Completed blocks are hashed back from flash, the end of their data may still be staged */
+    if (flashManager_.Flush() != FlashManager::RetStatus::eOk)
+    {
+        manifest_.ClearVerified();
+        return false;
+    }
+
+    return manifest_.VerifyPending();
+}
+
+void Bootloader::DropStreamedHashes()
+{
+    /* After a failed write the flash no longer holds what was hashed, validateFlash reads it all back */
+    imageHash_.Stop();
+    manifest_.ClearVerified();
+}
+
 Bootloader::RetStatus Bootloader::HandleFlashData(const beecom::Packet& packet)
 {
     uint32_t startAddress = ExtractAddress(packet);
     size_t dataSize = packet.header.length - sizeof(uint32_t);
     const uint8_t* dataStart = packet.payload + sizeof(uint32_t);
 
-    auto fStatus = flashManager_.Write(startAddress, dataStart, dataSize);
+    auto fStatus = FlashManager::RetStatus::eNotOk;
+    manifestAllowed_ = false;
 
-    if (fStatus == FlashManager::RetStatus::eOk)
+    if (!FlashMapping::IsBootloaderOwned(startAddress, dataSize))
+    {
+        fStatus = flashManager_.BufferedWrite(startAddress, dataStart, dataSize);
+    }
+
+    if (fStatus != FlashManager::RetStatus::eOk)
+    {
+        DropStreamedHashes();
+    }
+
+    /* A block that does not match the manifest ends the session right away */
+    if ((fStatus == FlashManager::RetStatus::eOk) && HashProgrammedData(startAddress, dataStart, dataSize))
     {
         SendAckResponse(static_cast<packetType>(packet.header.type));
         return RetStatus::eOk;
@@ -105,12 +281,513 @@ Bootloader::RetStatus Bootloader::HandleFlashData(const beecom::Packet& packet)
     }
 }
 
+Bootloader::RetStatus Bootloader::HandleFlashDataWindowed(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+    size_t headerSize = sizeof(uint16_t) + sizeof(uint32_t);
+
+    /* Compressed packets carry the decompressed size in front of the LZ4 block, fill packets the
+       size of the range and the pattern instead of data */
+    if (type == packetType::flashDataCompressed)
+    {
+        headerSize += sizeof(uint16_t);
+    }
+    else if (type == packetType::flashFill)
+    {
+        headerSize += sizeof(uint32_t) + sizeof(uint8_t);
+    }
+
+    manifestAllowed_ = false;
+
+    if (!transferWindow_.IsConfigured() || (packet.header.length < headerSize))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    auto result = transferWindow_.Accept(ExtractSequence(packet));
+
+    if (result == TransferWindow::Result::outOfWindow)
+    {
+        /* Host is ahead of the window, report the current state and let it retransmit */
+        SendWindowResponse(type, false);
+        return RetStatus::eOk;
+    }
+
+    if (result == TransferWindow::Result::accepted)
+    {
+        /* The decompressed data is written before the scope ends, nothing refers to it afterwards */
+        BootArena::Scope scope(BootArena::Phase::decompress);
+        uint32_t startAddress = ExtractAddress(packet, sizeof(uint16_t));
+        const uint8_t* data = packet.payload + headerSize;
+        size_t dataSize = packet.header.length - headerSize;
+        auto fStatus = FlashManager::RetStatus::eNotOk;
+        bool blockValid = true;
+
+        if (type == packetType::flashFill)
+        {
+            /* The range size uses the same encoding as the address */
+            uint32_t fillSize = ExtractAddress(packet, sizeof(uint16_t) + sizeof(uint32_t));
+
+            if (!FlashMapping::IsBootloaderOwned(startAddress, fillSize))
+            {
+                fStatus = flashManager_.Fill(startAddress, packet.payload[headerSize - 1U], fillSize);
+            }
+
+            if (fStatus == FlashManager::RetStatus::eOk)
+            {
+                imageHash_.AddFill(startAddress, packet.payload[headerSize - 1U], fillSize);
+                manifest_.Add(startAddress, fillSize);
+                blockValid = VerifyManifestBlocks();
+            }
+        }
+        else if (((type != packetType::flashDataCompressed) || DecompressPayload(packet, headerSize, data, dataSize))
+                 && !FlashMapping::IsBootloaderOwned(startAddress, dataSize))
+        {
+            fStatus = flashManager_.BufferedWrite(startAddress, data, dataSize);
+            blockValid = (fStatus == FlashManager::RetStatus::eOk) && HashProgrammedData(startAddress, data, dataSize);
+        }
+
+        if (fStatus != FlashManager::RetStatus::eOk)
+        {
+            DropStreamedHashes();
+        }
+
+        if ((fStatus != FlashManager::RetStatus::eOk) || !blockValid)
+        {
+            SendWindowResponse(type, false);
+            return RetStatus::eNotOk;
+        }
+    }
+
+    SendWindowResponse(type, true);
+    return RetStatus::eOk;
+}
+
+bool Bootloader::DecompressPayload(const beecom::Packet& packet, size_t headerSize, const uint8_t*& data,
+                                   size_t& dataSize)
+{
+    const uint8_t* sizeField = packet.payload + headerSize - sizeof(uint16_t);
+    size_t rawSize = (static_cast<size_t>(sizeField[0]) << 8U) | static_cast<size_t>(sizeField[1]);
+    size_t decodedSize = 0U;
+
+    if (rawSize > BootConfig::maxDecompressedSize)
+    {
+        return false;
+    }
+
+    auto* buffer = static_cast<uint8_t*>(BootArena::Allocate(rawSize));
+
+    if (buffer == nullptr)
+    {
+        return false;
+    }
+
+    auto dStatus = lz4Decoder_.Decode(data, dataSize, buffer, rawSize, decodedSize);
+
+    if ((dStatus != Lz4Decoder::RetStatus::eOk) || (decodedSize != rawSize))
+    {
+        return false;
+    }
+
+    data = buffer;
+    dataSize = decodedSize;
+    return true;
+}
+
+Bootloader::RetStatus Bootloader::HandleConfigureWindow(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+
+    if (packet.header.length != sizeof(uint8_t))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    const uint8_t response[] = {
+        0x55U,
+        transferWindow_.Configure(packet.payload[0], BootConfig::maxTransferWindowSize),
+        capabilityCompressedData | capabilityFill};
+
+    SendResponse(type, response, sizeof(response));
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleSetBaudRate(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+    uint32_t baudRate = 0U;
+
+    if (packet.header.length != sizeof(uint32_t))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    if ((transportHooks_.resolveBaudRate != nullptr) && (transportHooks_.setBaudRate != nullptr)
+        && (fallbackBaudRate_ == 0U))
+    {
+        baudRate = transportHooks_.resolveBaudRate(ExtractAddress(packet));
+    }
+
+    if (baudRate == 0U)
+    {
+        /* Not supported here, the host simply stays at the current rate */
+        SendNackResponse(type);
+        return RetStatus::eOk;
+    }
+
+    const uint8_t response[] = {
+        0x55U,
+        static_cast<uint8_t>(baudRate >> 24U),
+        static_cast<uint8_t>(baudRate >> 16U),
+        static_cast<uint8_t>(baudRate >> 8U),
+        static_cast<uint8_t>(baudRate)};
+
+    /* The acknowledgement still leaves at the old rate, the new one is kept only after a probe */
+    SendResponse(type, response, sizeof(response));
+    FlushTransport();
+    fallbackBaudRate_ = transportHooks_.setBaudRate(baudRate);
+    baudProbeStart_ = HAL_GetTick();
+
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleConfirmBaudRate(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+
+    if (packet.header.length != sizeof(uint32_t))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    /* The probe echoes the rate, receiving it intact proves both directions of the link */
+    fallbackBaudRate_ = 0U;
+    const uint8_t response[] = {0x55U, packet.payload[0], packet.payload[1], packet.payload[2], packet.payload[3]};
+
+    SendResponse(type, response, sizeof(response));
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleDeltaStart(const beecom::Packet& packet)
+{
+    constexpr size_t payloadSize = SecureBoot::hashSize + (2U * sizeof(uint32_t));
+    packetType type = static_cast<packetType>(packet.header.type);
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+    uint8_t digest[SecureBoot::hashSize];
+
+    imageHash_.Stop();
+    manifest_.Reset();
+    manifestAllowed_ = false;
+
+    /* The patch reads the installed image and uses the scratch sector, no erase may still be running */
+    if ((packet.header.length != payloadSize) || (flashManager_.Flush() != FlashManager::RetStatus::eOk)
+        || (flashManager_.CompleteErase(FlashMapping::appMinStartAddress, FlashMapping::appMaxEndAddress)
+            != FlashManager::RetStatus::eOk)
+        || !IsPresentFlagSet())
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    uint32_t newStartAddress = ExtractAddress(packet, SecureBoot::hashSize);
+    uint32_t newEndAddress = ExtractAddress(packet, SecureBoot::hashSize + sizeof(uint32_t));
+
+    /* A patch only applies to exactly the image it was generated from */
+    auto sStatus = SecureBoot::CalculateSHA256(
+        reinterpret_cast<const unsigned char*>(metaData->appStartAddress), FlashMapping::GetAppSize(), digest);
+    bool baseMatches = (sStatus == SecureBoot::RetStatus::valid)
+        && (std::memcmp(digest, packet.payload, SecureBoot::hashSize) == 0);
+
+    if (!baseMatches || (newStartAddress < FlashMapping::appMinStartAddress) || (newStartAddress >= newEndAddress)
+        || (deltaPatcher_.Start(metaData->appStartAddress, metaData->appEndAddress, newEndAddress)
+            != DeltaPatcher::RetStatus::eOk))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    /* Clearing the flag keeps an interrupted patch from ever being booted */
+    const uint32_t invalidFlag = 0U;
+    if (flashManager_.Write(FlashMapping::appValidFlagAddress, &invalidFlag, sizeof(invalidFlag))
+        != FlashManager::RetStatus::eOk)
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    SendAckResponse(type);
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleDeltaData(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+
+    if (deltaPatcher_.Apply(packet.payload, packet.header.length) != DeltaPatcher::RetStatus::eOk)
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    SendAckResponse(type);
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleGetSectorDigests(const beecom::Packet& packet)
+{
+    constexpr size_t entrySize = (2U * sizeof(uint32_t)) + SecureBoot::hashSize;
+    packetType type = static_cast<packetType>(packet.header.type);
+    uint8_t response[maxSectorDigests * entrySize];
+    size_t responseSize = 0U;
+    FlashManager::sectorInfo sector;
+    uint32_t address = FlashMapping::appMinStartAddress;
+
+    if ((flashManager_.Flush() != FlashManager::RetStatus::eOk)
+        || (flashManager_.CompleteErase(FlashMapping::appMinStartAddress, FlashMapping::appMaxEndAddress)
+            != FlashManager::RetStatus::eOk))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    /* Every entry is [start][size][SHA-256 of the whole sector] */
+    while ((address <= FlashMapping::appMaxEndAddress)
+           && (flashManager_.GetSectorInfo(address, sector) == FlashManager::RetStatus::eOk))
+    {
+        uint32_t sectorSize = sector.endAddress - sector.startAddress + 1U;
+        uint8_t* entry = &response[responseSize];
+
+        if ((responseSize + entrySize > sizeof(response))
+            || (SecureBoot::CalculateSHA256(reinterpret_cast<const unsigned char*>(sector.startAddress), sectorSize,
+                                            entry + (2U * sizeof(uint32_t)))
+                != SecureBoot::RetStatus::valid))
+        {
+            SendNackResponse(type);
+            return RetStatus::eNotOk;
+        }
+
+        StoreBigEndian(entry, sector.startAddress);
+        StoreBigEndian(entry + sizeof(uint32_t), sectorSize);
+        responseSize += entrySize;
+        address = sector.endAddress + 1U;
+    }
+
+    SendResponse(type, response, responseSize);
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleGetRangeDigest(const beecom::Packet& packet)
+{
+    packetType type = static_cast<packetType>(packet.header.type);
+    FlashManager::sectorInfo sector;
+    uint8_t response[1U + SecureBoot::hashSize] = {0x55U};
+    size_t responseSize = 0U;
+
+    /* Payload is [algorithm][start][size], the range has to lie in flash */
+    if (packet.header.length != sizeof(uint8_t) + (2U * sizeof(uint32_t)))
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    uint8_t algorithm = packet.payload[0];
+    uint32_t startAddress = ExtractAddress(packet, sizeof(uint8_t));
+    uint32_t size = ExtractAddress(packet, sizeof(uint8_t) + sizeof(uint32_t));
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(startAddress);
+
+    bool inFlash = (size != 0U) && (size - 1U <= UINT32_MAX - startAddress)
+        && (flashManager_.GetSectorInfo(startAddress, sector) == FlashManager::RetStatus::eOk)
+        && (flashManager_.GetSectorInfo(startAddress + size - 1U, sector) == FlashManager::RetStatus::eOk)
+        && (flashManager_.Flush() == FlashManager::RetStatus::eOk)
+        && (flashManager_.CompleteErase(startAddress, startAddress + size - 1U) == FlashManager::RetStatus::eOk);
+
+    if (inFlash && (algorithm == rangeDigestCrc32))
+    {
+        HardwareCrc crc;
+        StoreBigEndian(&response[1], crc.Calculate(data, size));
+        responseSize = 1U + sizeof(uint32_t);
+    }
+    else if (inFlash && (algorithm == rangeDigestSha256)
+             && (SecureBoot::CalculateSHA256(data, size, &response[1]) == SecureBoot::RetStatus::valid))
+    {
+        responseSize = 1U + SecureBoot::hashSize;
+    }
+
+    if (responseSize == 0U)
+    {
+        SendNackResponse(type);
+        return RetStatus::eOk;
+    }
+
+    SendResponse(type, response, responseSize);
+    return RetStatus::eOk;
+}
+
+Bootloader::RetStatus Bootloader::HandleFlashManifest(const beecom::Packet& packet)
+{
+    constexpr size_t headerSize = (2U * sizeof(uint32_t)) + sizeof(uint8_t) + sizeof(uint16_t);
+    packetType type = static_cast<packetType>(packet.header.type);
+    FlashMapping::ManifestHeader header{};
+    bool accepted = false;
+
+    /* Payload is [start][end][block size log2][first leaf] and then the leaves from first leaf on. With
+       first leaf at the block count the rest is the signature of the root instead. Data programmed
+       before the manifest would never be checked against it, so it has to follow flashStart directly. */
+    if (manifestAllowed_ && (packet.header.length >= headerSize))
+    {
+        header.marker = manifestMarker;
+        header.startAddress = ExtractAddress(packet);
+        header.endAddress = ExtractAddress(packet, sizeof(uint32_t));
+        header.blockSizeLog2 = packet.payload[2U * sizeof(uint32_t)];
+        size_t firstLeaf =
+            (static_cast<size_t>(packet.payload[headerSize - 2U]) << 8U) | packet.payload[headerSize - 1U];
+        const uint8_t* body = packet.payload + headerSize;
+        size_t bodySize = packet.header.length - headerSize;
+
+        accepted = (header.startAddress >= FlashMapping::appMinStartAddress)
+            && (header.endAddress <= FlashMapping::appMaxEndAddress + 1U)
+            && (manifest_.Configure(header.startAddress, header.endAddress, header.blockSizeLog2)
+                == MerkleManifest::RetStatus::eOk);
+
+        if (accepted && (firstLeaf < manifest_.GetBlockCount()))
+        {
+            accepted = (manifest_.AddLeaves(firstLeaf, body, bodySize) == MerkleManifest::RetStatus::eOk);
+        }
+        else if (accepted)
+        {
+            accepted = (firstLeaf == manifest_.GetBlockCount()) && AuthenticateManifest(header, body, bodySize);
+        }
+    }
+
+    if (!accepted)
+    {
+        SendNackResponse(type);
+        return RetStatus::eNotOk;
+    }
+
+    SendAckResponse(type);
+    return RetStatus::eOk;
+}
+
+bool Bootloader::AuthenticateManifest(FlashMapping::ManifestHeader& header, const uint8_t* signature,
+                                      size_t signatureSize)
+{
+    bool valid = false;
+
+    /* The header can only be programmed into erased metadata, so there is one manifest per session */
+    flashManager_.CompleteErase(FlashMapping::appMetaDataAddress, FlashMapping::appMetaDataAddress);
+    if ((FlashMapping::GetMetaData()->manifest.marker != 0xFFFFFFFFU) || !manifest_.CalculateRoot(header.root))
+    {
+        return false;
+    }
+
+    {
+        BootArena::Scope scope(BootArena::Phase::verify);
+        SecureBootBackend secureBoot;
+        valid = (secureBoot.ValidateHash(signature, signatureSize, header.root) == SecureBoot::RetStatus::valid);
+    }
+
+    /* Marker last, a header cut short by a reset is never taken as a manifest */
+    constexpr size_t markerSize = sizeof(header.marker);
+    valid = valid
+        && (flashManager_.Write(FlashMapping::appManifestAddress + markerSize,
+                                reinterpret_cast<const uint8_t*>(&header) + markerSize, sizeof(header) - markerSize)
+            == FlashManager::RetStatus::eOk)
+        && (flashManager_.Write(FlashMapping::appManifestAddress, &header.marker, markerSize)
+            == FlashManager::RetStatus::eOk);
+
+    if (valid)
+    {
+        manifest_.SetAuthenticated();
+    }
+
+    return valid;
+}
+
 Bootloader::RetStatus Bootloader::HandleFlashStart(const beecom::Packet& packet)
 {
-    auto fStatus = flashManager_.Erase(FlashMapping::appMinStartAddress, FlashMapping::appMaxEndAddress);
+    constexpr size_t rangeSize = 2U * sizeof(uint32_t);
+    auto fStatus = FlashManager::RetStatus::eOk;
+    FlashManager::sectorInfo sector;
+
+    /* Whatever an aborted session left staged must not end up in the new image */
+    flashManager_.Discard();
+    manifest_.Reset();
+    manifestAllowed_ = false;
+
+    /* Sectors are only recorded here and erased while the data is on its way, see FlashManager::ProcessErase */
+    if (packet.header.length == 0U)
+    {
+        fStatus = flashManager_.ScheduleErase(FlashMapping::appMinStartAddress, FlashMapping::appMaxEndAddress);
+        hashedEraseEnd_ = FlashMapping::appMaxEndAddress;
+    }
+    else if ((packet.header.length % rangeSize) != 0U)
+    {
+        fStatus = FlashManager::RetStatus::eNotOk;
+    }
+    else
+    {
+        /* Incremental update, only the listed [start, end] ranges are erased. The metadata sector is
+           erased in any case because the new image always rewrites the metadata. */
+        fStatus = flashManager_.ScheduleErase(FlashMapping::appMetaDataAddress, FlashMapping::appMetaDataAddress);
+        hashedEraseEnd_ = 0U;
+
+        if ((fStatus == FlashManager::RetStatus::eOk)
+            && (flashManager_.GetSectorInfo(FlashMapping::appMetaDataAddress, sector) == FlashManager::RetStatus::eOk))
+        {
+            hashedEraseEnd_ = sector.endAddress;
+        }
+
+        for (size_t offset = 0U; (offset < packet.header.length) && (fStatus == FlashManager::RetStatus::eOk);
+             offset += rangeSize)
+        {
+            uint32_t startAddress = ExtractAddress(packet, offset);
+            uint32_t endAddress = ExtractAddress(packet, offset + sizeof(uint32_t));
+
+            if ((startAddress < FlashMapping::appMinStartAddress) || (endAddress > FlashMapping::appMaxEndAddress)
+                || (startAddress > endAddress))
+            {
+                fStatus = FlashManager::RetStatus::eNotOk;
+            }
+            else
+            {
+                fStatus = flashManager_.ScheduleErase(startAddress, endAddress);
+            }
+
+            /* Ranges continuing the erased area grow it, whole sectors are erased */
+            if ((fStatus == FlashManager::RetStatus::eOk) && (hashedEraseEnd_ != 0U)
+                && (startAddress <= hashedEraseEnd_ + 1U)
+                && (flashManager_.GetSectorInfo(endAddress, sector) == FlashManager::RetStatus::eOk))
+            {
+                hashedEraseEnd_ = std::max(hashedEraseEnd_, sector.endAddress);
+            }
+        }
+    }
+
+    /* The flash stays unlocked for the programming session, until validateFlash */
+    if (fStatus == FlashManager::RetStatus::eOk)
+    {
+        fStatus = flashManager_.Unlock();
+    }
+
+    /* The image is hashed while it is programmed as long as every sector it can reach is erased, gaps are
+       then known to be blank. Sectors kept by an incremental update are not seen. */
+    if ((fStatus == FlashManager::RetStatus::eOk) && (hashedEraseEnd_ != 0U))
+    {
+        imageHash_.Start();
+    }
+    else
+    {
+        imageHash_.Stop();
+    }
 
     if (fStatus == FlashManager::RetStatus::eOk)
     {
+        manifestAllowed_ = true;
         SendAckResponse(static_cast<packetType>(packet.header.type));
         return RetStatus::eOk;
     }
@@ -123,8 +800,20 @@ Bootloader::RetStatus Bootloader::HandleFlashStart(const beecom::Packet& packet)
 
 Bootloader::RetStatus Bootloader::HandleValidateSignature(const beecom::Packet& packet)
 {
-    flashManager_.Write(FlashMapping::appSignatureSizeAddress, packet.payload, packet.header.length);
-    bool valid = ValidateFirmware();
+    manifestAllowed_ = false;
+
+    /* Data still staged by BufferedWrite has to be in flash before it is validated */
+    bool valid = (flashManager_.Flush() == FlashManager::RetStatus::eOk);
+
+    /* [signature size][signature], it must not reach the valid flag and what follows it */
+    valid = valid
+        && (packet.header.length <= FlashMapping::appValidFlagAddress - FlashMapping::appSignatureSizeAddress)
+        && (flashManager_.Write(FlashMapping::appSignatureSizeAddress, packet.payload, packet.header.length)
+            == FlashManager::RetStatus::eOk);
+
+    /* End of the programming session, the flag write below unlocks for itself */
+    flashManager_.Lock();
+    valid = valid && ValidateFirmware();
 
     if (valid)
     {
@@ -133,8 +822,19 @@ Bootloader::RetStatus Bootloader::HandleValidateSignature(const beecom::Packet&
             flashManager_.Write(FlashMapping::appValidFlagAddress, &applicationValidFlag, sizeof(applicationValidFlag));
         if (FlashManager::RetStatus::eOk == fStatus)
         {
+#if (FAST_BOOT_VALIDATION == 1)
+            WriteValidationRecord();
+#endif
+            /* The acknowledgement carries the cycles of the signature verify */
+            const uint8_t response[] = {
+                0x55U,
+                static_cast<uint8_t>(validationCycles_ >> 24U),
+                static_cast<uint8_t>(validationCycles_ >> 16U),
+                static_cast<uint8_t>(validationCycles_ >> 8U),
+                static_cast<uint8_t>(validationCycles_)};
+
             TransitionState(BootState::booting);
-            SendAckResponse(static_cast<packetType>(packet.header.type));
+            SendResponse(static_cast<packetType>(packet.header.type), response, sizeof(response));
             return RetStatus::eOk;
         }
         else
@@ -152,21 +852,22 @@ Bootloader::RetStatus Bootloader::HandleValidateSignature(const beecom::Packet&
 
 Bootloader::RetStatus Bootloader::HandleReadDataRequest(const beecom::Packet& packet)
 {
-    uint8_t dataBuffer[FlashMapping::maxDataSize];
+    const uint8_t* data = nullptr;
     size_t dataSize = 0;
     packetType type = static_cast<packetType>(packet.header.type);
     Bootloader::RetStatus status = Bootloader::RetStatus::okNoResponse;
 
+    /* Responses point straight at flash, the transport copies what a later erase could change */
     switch (type)
     {
         case packetType::getAppSignature:
-            flashManager_.Read(
-                FlashMapping::appSignatureAddress, dataBuffer, FlashMapping::GetMetaData()->signatureSize);
-            dataSize = FlashMapping::GetMetaData()->signatureSize;
+            flashManager_.CompleteErase(FlashMapping::appMetaDataAddress, FlashMapping::appMetaDataAddress);
+            data = reinterpret_cast<const uint8_t*>(FlashMapping::appSignatureAddress);
+            dataSize = std::min<size_t>(FlashMapping::GetMetaData()->signatureSize, FlashMapping::appSignatureMaxSize);
             break;
         case packetType::getBootloaderVersion:
+            data = reinterpret_cast<const uint8_t*>(BootConfig::bootloaderVersion);
             dataSize = sizeof(BootConfig::bootloaderVersion);
-            std::memcpy(dataBuffer, BootConfig::bootloaderVersion, dataSize);
             break;
         default:
             status = Bootloader::RetStatus::eNotOk;
@@ -175,7 +876,7 @@ Bootloader::RetStatus Bootloader::HandleReadDataRequest(const beecom::Packet& pa
 
     if (status == Bootloader::RetStatus::okNoResponse)
     {
-        SendResponse(type, dataBuffer, dataSize);
+        SendResponse(type, data, dataSize);
     }
 
     return status;
@@ -183,18 +884,136 @@ Bootloader::RetStatus Bootloader::HandleReadDataRequest(const beecom::Packet& pa
 
 bool Bootloader::ValidateFirmware()
 {
-#if (ECC_FIRMWARE_VALIDATION == 1)
-    SecureBootECC secureBoot;
-#elif (RSA_FIRMWARE_VALIDATION == 1)
-    SecureBootRSA secureBoot;
-#endif
-    SecureBoot::RetStatus sStatus = secureBoot.ValidateFirmware(
-        reinterpret_cast<const unsigned char*>(FlashMapping::appSignatureAddress),
-        FlashMapping::GetMetaData()->signatureSize,
-        reinterpret_cast<const unsigned char*>(FlashMapping::GetMetaData()->appStartAddress),
-        FlashMapping::GetAppSize());
+    /* Opened before secureBoot, whose mbedtls heap comes from the arena and is released with the scope */
+    BootArena::Scope scope(BootArena::Phase::verify);
+    SecureBootBackend secureBoot;
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+
+    /* Sectors past the image may still be erasing, only the ones being checked have to be done */
+    bool erased = (flashManager_.CompleteErase(FlashMapping::appMetaDataAddress, FlashMapping::appMetaDataAddress)
+                   == FlashManager::RetStatus::eOk)
+        && (flashManager_.CompleteErase(metaData->appStartAddress, metaData->appEndAddress)
+            == FlashManager::RetStatus::eOk);
+
+    const FlashMapping::ManifestHeader& manifest = metaData->manifest;
+    uint8_t hash[SecureBoot::hashSize];
+    bool valid = false;
+
+    if (manifest.marker == manifestMarker)
+    {
+        /* The signature covers the manifest root, only blocks not verified while programming are read back */
+        valid = (manifest.startAddress == metaData->appStartAddress) && (manifest.endAddress == metaData->appEndAddress)
+            && manifest_.VerifyImage(manifest.startAddress, manifest.endAddress, manifest.blockSizeLog2, manifest.root)
+            && ValidateSignature(secureBoot, manifest.root);
+    }
+    else
+    {
+        /* The hash built up while programming saves reading the image back, any doubt gets the full pass. It
+           takes gaps for erased flash, which a failed or partial erase does not hold up. */
+        valid = erased && (metaData->appEndAddress - 1U <= hashedEraseEnd_)
+            && imageHash_.Finish(metaData->appStartAddress, metaData->appEndAddress, hash)
+            && ValidateSignature(secureBoot, hash);
+
+        if (!valid)
+        {
+            valid = ImageDigest::Calculate(reinterpret_cast<const uint8_t*>(metaData->appStartAddress),
+                                           FlashMapping::GetAppSize(), hash)
+                && ValidateSignature(secureBoot, hash);
+        }
+    }
+
+    return valid;
+}
+
+bool Bootloader::ValidateSignature(SecureBoot& secureBoot, const uint8_t* hash)
+{
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+    /* Only the verify is timed, hashing depends on the image size and on how the digest came about */
+    CycleCounter cycles;
+    bool valid =
+        (secureBoot.ValidateHash(metaData->signature, metaData->signatureSize, hash) == SecureBoot::RetStatus::valid);
+
+    validationCycles_ = cycles.Elapsed();
+    return valid;
+}
+
+bool Bootloader::CalculateRecordMac(uint32_t imageCrc, uint8_t* mac)
+{
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+    const uint8_t* key = FlashMapping::GetOtpBlock(BootConfig::validationKeyOtpBlock);
+    size_t signatureSize = std::min<size_t>(metaData->signatureSize, FlashMapping::appSignatureMaxSize);
+    uint8_t message[(6U * sizeof(uint32_t)) + FlashMapping::appSignatureMaxSize];
+
+    /* Without a provisioned and locked device key no record is written or accepted */
+    if (!FlashMapping::IsOtpBlockLocked(BootConfig::validationKeyOtpBlock)
+        || FlashKernels::IsErased(key, FlashMapping::otpBlockSize))
+    {
+        return false;
+    }
+
+    /* Bound to this device, the image range and its signature */
+    StoreBigEndian(&message[0], HAL_GetUIDw0());
+    StoreBigEndian(&message[4], HAL_GetUIDw1());
+    StoreBigEndian(&message[8], HAL_GetUIDw2());
+    StoreBigEndian(&message[12], metaData->appStartAddress);
+    StoreBigEndian(&message[16], metaData->appEndAddress);
+    StoreBigEndian(&message[20], imageCrc);
+    std::memcpy(&message[24], metaData->signature, signatureSize);
+
+    return SecureBoot::CalculateHMAC(key, FlashMapping::otpBlockSize, message, 24U + signatureSize, mac)
+        == SecureBoot::RetStatus::valid;
+}
+
+bool Bootloader::IsValidationRecordValid()
+{
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+    const FlashMapping::ValidationRecord& record = metaData->validationRecord;
+    uint8_t mac[SecureBoot::hashSize];
+
+    if ((record.marker != validationRecordMarker) || (metaData->appStartAddress < FlashMapping::appMinStartAddress)
+        || (metaData->appStartAddress >= metaData->appEndAddress)
+        || (metaData->appEndAddress > FlashMapping::appMaxEndAddress + 1U))
+    {
+        return false;
+    }
 
-    return sStatus == SecureBoot::RetStatus::valid;
+    HardwareCrc crc;
+    uint32_t imageCrc = crc.Calculate(reinterpret_cast<const uint8_t*>(metaData->appStartAddress),
+                                      FlashMapping::GetAppSize());
+
+    return (imageCrc == record.imageCrc) && CalculateRecordMac(imageCrc, mac)
+        && (std::memcmp(mac, record.mac, sizeof(mac)) == 0);
+}
+
+void Bootloader::WriteValidationRecord()
+{
+    const FlashMapping::MetaData* metaData = FlashMapping::GetMetaData();
+    FlashMapping::ValidationRecord record;
+
+    /* The record can only be programmed into erased flash, a stale one stays until the next update */
+    if (metaData->validationRecord.marker != 0xFFFFFFFFU)
+    {
+        return;
+    }
+
+    HardwareCrc crc;
+    record.marker = validationRecordMarker;
+    record.imageCrc = crc.Calculate(reinterpret_cast<const uint8_t*>(metaData->appStartAddress),
+                                    FlashMapping::GetAppSize());
+
+    if (!CalculateRecordMac(record.imageCrc, record.mac))
+    {
+        return;
+    }
+
+    /* Marker last, a record cut short by a reset is never taken as valid */
+    constexpr size_t markerSize = sizeof(record.marker);
+    if (flashManager_.Write(FlashMapping::appValidationRecordAddress + markerSize,
+                            reinterpret_cast<const uint8_t*>(&record) + markerSize, sizeof(record) - markerSize)
+        == FlashManager::RetStatus::eOk)
+    {
+        flashManager_.Write(FlashMapping::appValidationRecordAddress, &record.marker, markerSize);
+    }
 }
 
 Bootloader::BootState Bootloader::DetermineTargetState(packetType type)
@@ -202,8 +1021,14 @@ Bootloader::BootState Bootloader::DetermineTargetState(packetType type)
     switch (type)
     {
         case packetType::flashStart:
+        case packetType::deltaStart:
             return BootState::erasing;
         case packetType::flashData:
+        case packetType::flashDataWindowed:
+        case packetType::flashDataCompressed:
+        case packetType::deltaData:
+        case packetType::flashFill:
+        case packetType::flashManifest:
             return BootState::flashing;
         case packetType::validateFlash:
             return BootState::verifying;
@@ -260,17 +1085,41 @@ void Bootloader::Boot()
             bootWaitTime = BootConfig::actionBootExtensionMs;
         }
 
+        /* One packet per pass, so reception keeps up while the handlers program flash */
+        ProcessPendingPacket();
+        CheckBaudRateProbe();
+
+        /* A sector erase stalls the CPU, SysTick included, for up to 2 s. None is started while the host
+           waits for a baud rate probe or for the answer to a packet already received. */
+        if ((fallbackBaudRate_ == 0U) && packetPool_.IsEmpty())
+        {
+            flashManager_.ProcessErase();
+        }
+
         if ((HAL_GetTick() - startTime > bootWaitTime) || (state == BootState::booting))
         {
             if (TransitionState(BootState::booting))
             {
+                /* Nothing may still be erasing once the application runs */
+                flashManager_.Flush();
+                flashManager_.CompleteErase(FlashMapping::appMinStartAddress, FlashMapping::appMaxEndAddress);
+                flashManager_.Lock();
                 bool presentFlagSet = IsPresentFlagSet();
                 bool firmwareValid = true;
-#if (VALIDATE_APP_BEFORE_BOOT == 1)
+#if (VALIDATE_APP_BEFORE_BOOT == 1) && (FAST_BOOT_VALIDATION == 1)
+                firmwareValid = IsValidationRecordValid();
+                if (!firmwareValid && ValidateFirmware())
+                {
+                    firmwareValid = true;
+                    WriteValidationRecord();
+                }
+#elif (VALIDATE_APP_BEFORE_BOOT == 1)
                 firmwareValid = ValidateFirmware();
 #endif
                 if (presentFlagSet && firmwareValid)
                 {
+                    /* Let queued responses leave before the peripherals are reset */
+                    FlushTransport();
                     AppJumper appJumper;
                     appJumper.JumpToApplication();
                     return;
@@ -3,6 +3,13 @@
 #include <array>
 #include "BeeCom.h"
 #include "FlashManager.h"
+#include "TransferWindow.h"
+#include "Lz4Decoder.h"
+#include "DeltaPatcher.h"
+#include "PacketPool.h"
+#include "ImageHash.h"
+#include "MerkleManifest.h"
+#include "BootConfig.h"
 
 class Bootloader;
 
@@ -41,6 +48,17 @@ class Bootloader
         validateFlash,
         getBootloaderVersion,
         getAppSignature,
+        configureWindow,
+        flashDataWindowed,
+        setBaudRate,
+        confirmBaudRate,
+        flashDataCompressed,
+        deltaStart,
+        deltaData,
+        flashFill,
+        getSectorDigests,
+        getRangeDigest,
+        flashManifest,
         numberOfPacketTypes
     };
 
@@ -53,15 +71,45 @@ class Bootloader
 
     using HandlerFunction = RetStatus (Bootloader::*)(const beecom::Packet&);
 
+    /* Optional hooks into the link below BeeCOM, unset members are skipped */
+    struct TransportHooks
+    {
+        void (*flush)();
+        /* Rate the link can actually run at for a requested one (0 = fastest), 0 if not supported */
+        uint32_t (*resolveBaudRate)(uint32_t requested);
+        /* Switches the link rate and returns the previous one */
+        uint32_t (*setBaudRate)(uint32_t baudRate);
+    };
+
     Bootloader(beecom::BeeCOM& beecom, FlashManager& flashManager);
 
+    void SetTransportHooks(const TransportHooks& hooks);
     void Boot();
 
+    /* Core cycles of the last signature verify, hashing the image is not included. The validateFlash
+       acknowledgement reports it to the host as well. */
+    uint32_t GetValidationCycles() const;
+
   private:
     beecom::BeeCOM& beecom_;
     FlashManager& flashManager_;
     BootPacketProcessor packetProcessor{*this};
     BootState state{BootState::idle};
+    TransferWindow transferWindow_;
+    TransportHooks transportHooks_{};
+    uint32_t fallbackBaudRate_{0U};
+    uint32_t baudProbeStart_{0U};
+    uint32_t validationCycles_{0U};
+    Lz4Decoder lz4Decoder_;
+    DeltaPatcher deltaPatcher_{flashManager_};
+    ImageHash imageHash_;
+    /* Erased by flashStart from the metadata sector on up to here, the streamed hash only covers an
+       image that ends below it */
+    uint32_t hashedEraseEnd_{0U};
+    MerkleManifest manifest_;
+    /* A manifest is only taken between flashStart and the first data of the session */
+    bool manifestAllowed_{false};
+    PacketPool<BootConfig::packetPoolSlots, BootConfig::maxPacketPayloadSize> packetPool_;
     std::array<HandlerFunction, static_cast<size_t>(packetType::numberOfPacketTypes)> packetHandlers;
 
     bool TransitionState(BootState newState);
@@ -70,14 +118,39 @@ class Bootloader
     void SendResponse(packetType type, const uint8_t* data, size_t dataSize);
     void SendAckResponse(packetType type);
     void SendNackResponse(packetType type);
+    void SendWindowResponse(packetType type, bool ack);
+    void FlushTransport();
+    void CheckBaudRateProbe();
 
     bool IsPresentFlagSet();
     bool IsJumpToBootFlagSet();
     bool ValidateFirmware();
-
+    bool ValidateSignature(SecureBoot& secureBoot, const uint8_t* hash);
+    bool CalculateRecordMac(uint32_t imageCrc, uint8_t* mac);
+    bool IsValidationRecordValid();
+    void WriteValidationRecord();
+
+    bool HashProgrammedData(uint32_t address, const uint8_t* data, size_t size);
+    bool VerifyManifestBlocks();
+    void DropStreamedHashes();
+    bool AuthenticateManifest(FlashMapping::ManifestHeader& header, const uint8_t* signature, size_t signatureSize);
+
+    void QueuePacket(const beecom::Packet& packet);
+    bool ProcessPendingPacket();
     void HandleValidPacket(const beecom::Packet& packet);
-    uint32_t ExtractAddress(const beecom::Packet& packet);
+    uint32_t ExtractAddress(const beecom::Packet& packet, size_t offset = 0U);
+    uint16_t ExtractSequence(const beecom::Packet& packet);
     RetStatus HandleFlashData(const beecom::Packet& packet);
+    RetStatus HandleFlashDataWindowed(const beecom::Packet& packet);
+    bool DecompressPayload(const beecom::Packet& packet, size_t headerSize, const uint8_t*& data, size_t& dataSize);
+    RetStatus HandleConfigureWindow(const beecom::Packet& packet);
+    RetStatus HandleSetBaudRate(const beecom::Packet& packet);
+    RetStatus HandleConfirmBaudRate(const beecom::Packet& packet);
+    RetStatus HandleDeltaStart(const beecom::Packet& packet);
+    RetStatus HandleDeltaData(const beecom::Packet& packet);
+    RetStatus HandleGetSectorDigests(const beecom::Packet& packet);
+    RetStatus HandleGetRangeDigest(const beecom::Packet& packet);
+    RetStatus HandleFlashManifest(const beecom::Packet& packet);
     RetStatus HandleFlashStart(const beecom::Packet& packet);
     RetStatus HandleValidateSignature(const beecom::Packet& packet);
     RetStatus HandleReadDataRequest(const beecom::Packet& packet);
@@ -0,0 +1,218 @@
+#include "DeltaPatcher.h"
+
+namespace {
+uint32_t ReadU32(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24U) | (static_cast<uint32_t>(data[1]) << 16U)
+        | (static_cast<uint32_t>(data[2]) << 8U) | static_cast<uint32_t>(data[3]);
+}
+
+uint16_t ReadU16(const uint8_t* data)
+{
+    return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8U) | data[1]);
+}
+} // namespace
+
+DeltaPatcher::DeltaPatcher(FlashManager& flashManager) : flashManager_(flashManager) {}
+
+DeltaPatcher::RetStatus DeltaPatcher::Start(uint32_t oldStartAddress, uint32_t oldEndAddress, uint32_t newEndAddress)
+{
+    active_ = false;
+    sectorOpen_ = false;
+    replacedSectors_ = 0U;
+
+    if (flashManager_.GetSectorInfo(FlashMapping::deltaScratchAddress, scratch_) != FlashManager::RetStatus::eOk)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    /* Neither image may overlap the scratch sector */
+    if ((oldStartAddress > oldEndAddress) || (oldEndAddress > scratch_.startAddress)
+        || (newEndAddress > scratch_.startAddress))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    oldStartAddress_ = oldStartAddress;
+    oldEndAddress_ = oldEndAddress;
+    active_ = true;
+
+    return RetStatus::eOk;
+}
+
+DeltaPatcher::RetStatus DeltaPatcher::Apply(const uint8_t* records, size_t size)
+{
+    const uint8_t* end = records + size;
+    RetStatus status = active_ ? RetStatus::eOk : RetStatus::eNotOk;
+
+    /* Records never span packets, a truncated one is an error */
+    while ((records < end) && (status == RetStatus::eOk))
+    {
+        size_t remaining = static_cast<size_t>(end - records);
+        Record record = static_cast<Record>(*records++);
+        --remaining;
+
+        switch (record)
+        {
+            case Record::sectorBegin:
+                if (remaining < sizeof(uint32_t))
+                {
+                    return RetStatus::eNotOk;
+                }
+                status = BeginSector(ReadU32(records));
+                records += sizeof(uint32_t);
+                break;
+            case Record::copy:
+                if (remaining < (2U * sizeof(uint32_t)) + sizeof(uint16_t))
+                {
+                    return RetStatus::eNotOk;
+                }
+                status = Copy(ReadU32(records), ReadU32(records + 4U), ReadU16(records + 8U));
+                records += (2U * sizeof(uint32_t)) + sizeof(uint16_t);
+                break;
+            case Record::insert:
+            {
+                if (remaining < sizeof(uint32_t) + sizeof(uint16_t))
+                {
+                    return RetStatus::eNotOk;
+                }
+                uint16_t length = ReadU16(records + 4U);
+                if (remaining - (sizeof(uint32_t) + sizeof(uint16_t)) < length)
+                {
+                    return RetStatus::eNotOk;
+                }
+                status = Insert(ReadU32(records), records + sizeof(uint32_t) + sizeof(uint16_t), length);
+                records += sizeof(uint32_t) + sizeof(uint16_t) + length;
+                break;
+            }
+            case Record::sectorEnd:
+                status = EndSector();
+                break;
+            default:
+                status = RetStatus::eNotOk;
+                break;
+        }
+    }
+
+    if (status != RetStatus::eOk)
+    {
+        active_ = false;
+    }
+
+    return status;
+}
+
+DeltaPatcher::RetStatus DeltaPatcher::BeginSector(uint32_t address)
+{
+    if (sectorOpen_ || (flashManager_.GetSectorInfo(address, target_) != FlashManager::RetStatus::eOk))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    bool isAppSector = (target_.startAddress >= FlashMapping::appMinStartAddress)
+        && (target_.endAddress < scratch_.startAddress);
+    bool fitsScratch = (target_.endAddress - target_.startAddress) <= (scratch_.endAddress - scratch_.startAddress);
+
+    if (!isAppSector || !fitsScratch || ((replacedSectors_ & (1UL << target_.index)) != 0U))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    if (flashManager_.Erase(scratch_.startAddress, scratch_.endAddress) != FlashManager::RetStatus::eOk)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    writeAddress_ = target_.startAddress;
+    sectorOpen_ = true;
+
+    return RetStatus::eOk;
+}
+
+bool DeltaPatcher::ReserveTarget(uint32_t destination, size_t size)
+{
+    /* Destinations only move forward, skipped bytes stay erased */
+    if (!sectorOpen_ || (destination < writeAddress_) || (size > target_.endAddress - destination + 1U)
+        || FlashMapping::IsBootloaderOwned(destination, size))
+    {
+        return false;
+    }
+
+    writeAddress_ = destination + size;
+    return true;
+}
+
+bool DeltaPatcher::IsOldDataIntact(uint32_t address, size_t size)
+{
+    FlashManager::sectorInfo first;
+    FlashManager::sectorInfo last;
+
+    if ((size == 0U) || (address < oldStartAddress_) || (size > oldEndAddress_ - address))
+    {
+        return false;
+    }
+
+    if ((flashManager_.GetSectorInfo(address, first) != FlashManager::RetStatus::eOk)
+        || (flashManager_.GetSectorInfo(address + size - 1U, last) != FlashManager::RetStatus::eOk))
+    {
+        return false;
+    }
+
+    for (uint32_t i = first.index; i <= last.index; ++i)
+    {
+        if ((replacedSectors_ & (1UL << i)) != 0U)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+DeltaPatcher::RetStatus DeltaPatcher::Copy(uint32_t destination, uint32_t source, size_t size)
+{
+    if (!IsOldDataIntact(source, size) || !ReserveTarget(destination, size))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    uint32_t scratchAddress = scratch_.startAddress + (destination - target_.startAddress);
+    auto fStatus = flashManager_.Write(scratchAddress, reinterpret_cast<const void*>(source), size);
+
+    return (fStatus == FlashManager::RetStatus::eOk) ? RetStatus::eOk : RetStatus::eNotOk;
+}
+
+DeltaPatcher::RetStatus DeltaPatcher::Insert(uint32_t destination, const uint8_t* data, size_t size)
+{
+    if (!ReserveTarget(destination, size))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    uint32_t scratchAddress = scratch_.startAddress + (destination - target_.startAddress);
+    auto fStatus = flashManager_.Write(scratchAddress, data, size);
+
+    return (fStatus == FlashManager::RetStatus::eOk) ? RetStatus::eOk : RetStatus::eNotOk;
+}
+
+DeltaPatcher::RetStatus DeltaPatcher::EndSector()
+{
+    if (!sectorOpen_)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    sectorOpen_ = false;
+    replacedSectors_ |= 1UL << target_.index;
+
+    /* From here on the old content of this sector is gone */
+    if (flashManager_.Erase(target_.startAddress, target_.endAddress) != FlashManager::RetStatus::eOk)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    auto fStatus = flashManager_.Write(target_.startAddress, reinterpret_cast<const void*>(scratch_.startAddress),
+                                       writeAddress_ - target_.startAddress);
+
+    return (fStatus == FlashManager::RetStatus::eOk) ? RetStatus::eOk : RetStatus::eNotOk;
+}
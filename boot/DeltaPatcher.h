@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "FlashManager.h"
+
+/* Applies a patch that rebuilds the application from the image already in flash. The patch is a
+   stream of records, each changed sector is opened, assembled in the scratch sector from pieces of
+   the old image (copy) and new bytes (insert), then erased and replaced by the scratch content.
+   A copy may only read sectors that have not been replaced yet, the host orders the patch so. */
+class DeltaPatcher
+{
+  public:
+    enum class RetStatus
+    {
+        eOk,
+        eNotOk
+    };
+
+    explicit DeltaPatcher(FlashManager& flashManager);
+
+    RetStatus Start(uint32_t oldStartAddress, uint32_t oldEndAddress, uint32_t newEndAddress);
+    RetStatus Apply(const uint8_t* records, size_t size);
+
+  private:
+    enum class Record : uint8_t
+    {
+        sectorBegin = 0x01U,
+        copy = 0x02U,
+        insert = 0x03U,
+        sectorEnd = 0x04U
+    };
+
+    FlashManager& flashManager_;
+    FlashManager::sectorInfo scratch_{};
+    FlashManager::sectorInfo target_{};
+    uint32_t oldStartAddress_{0U};
+    uint32_t oldEndAddress_{0U};
+    uint32_t writeAddress_{0U};
+    uint32_t replacedSectors_{0U};
+    bool active_{false};
+    bool sectorOpen_{false};
+
+    RetStatus BeginSector(uint32_t address);
+    RetStatus Copy(uint32_t destination, uint32_t source, size_t size);
+    RetStatus Insert(uint32_t destination, const uint8_t* data, size_t size);
+    RetStatus EndSector();
+    bool ReserveTarget(uint32_t destination, size_t size);
+    bool IsOldDataIntact(uint32_t address, size_t size);
+};
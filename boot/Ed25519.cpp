@@ -0,0 +1,674 @@
+#include "Ed25519.h"
+#include "BootAlgorithm.h"
+#include <cstring>
+
+extern "C"
+{
+#include "mbedtls/sha512.h"
+}
+
+/* mbedtls has SHA-512 only with Ed25519 selected */
+#if (ED25519_FIRMWARE_VALIDATION == 1)
+
+namespace {
+/* Value of sum(v[i] * 2^ceil(25.5 * i)) modulo 2^255 - 19 */
+struct FieldElement
+{
+    int32_t v[10];
+};
+
+/* Extended coordinates, x = X / Z, y = Y / Z, x * y = T / Z */
+struct Point
+{
+    FieldElement X;
+    FieldElement Y;
+    FieldElement Z;
+    FieldElement T;
+};
+
+/* Addend form of a point, saves the multiplication by 2d in every addition */
+struct CachedPoint
+{
+    FieldElement YplusX;
+    FieldElement YminusX;
+    FieldElement Z;
+    FieldElement T2d;
+};
+
+constexpr size_t fieldSize = 32U;
+constexpr size_t windowEntries = 8U;
+constexpr size_t scalarBits = 256U;
+
+constexpr uint8_t curveD[fieldSize] = {0xA3U, 0x78U, 0x59U, 0x13U, 0xCAU, 0x4DU, 0xEBU, 0x75U, 0xABU, 0xD8U, 0x41U,
+                                       0x41U, 0x4DU, 0x0AU, 0x70U, 0x00U, 0x98U, 0xE8U, 0x79U, 0x77U, 0x79U, 0x40U,
+                                       0xC7U, 0x8CU, 0x73U, 0xFEU, 0x6FU, 0x2BU, 0xEEU, 0x6CU, 0x03U, 0x52U};
+constexpr uint8_t curve2D[fieldSize] = {0x59U, 0xF1U, 0xB2U, 0x26U, 0x94U, 0x9BU, 0xD6U, 0xEBU, 0x56U, 0xB1U, 0x83U,
+                                        0x82U, 0x9AU, 0x14U, 0xE0U, 0x00U, 0x30U, 0xD1U, 0xF3U, 0xEEU, 0xF2U, 0x80U,
+                                        0x8EU, 0x19U, 0xE7U, 0xFCU, 0xDFU, 0x56U, 0xDCU, 0xD9U, 0x06U, 0x24U};
+constexpr uint8_t sqrtMinusOne[fieldSize] = {0xB0U, 0xA0U, 0x0EU, 0x4AU, 0x27U, 0x1BU, 0xEEU, 0xC4U,
+                                             0x78U, 0xE4U, 0x2FU, 0xADU, 0x06U, 0x18U, 0x43U, 0x2FU,
+                                             0xA7U, 0xD7U, 0xFBU, 0x3DU, 0x99U, 0x00U, 0x4DU, 0x2BU,
+                                             0x0BU, 0xDFU, 0xC1U, 0x4FU, 0x80U, 0x24U, 0x83U, 0x2BU};
+/* Encoded base point, y = 4/5 with positive x */
+constexpr uint8_t basePoint[fieldSize] = {0x58U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U,
+                                          0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U,
+                                          0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U,
+                                          0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U, 0x66U};
+/* Group order L = 2^252 + 27742317777372353535851937790883648493, little-endian */
+constexpr int64_t groupOrder[fieldSize] = {0xED, 0xD3, 0xF5, 0x5C, 0x1A, 0x63, 0x12, 0x58, 0xD6, 0x9C, 0xF7,
+                                           0xA2, 0xDE, 0xF9, 0xDE, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                           0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10};
+
+unsigned LimbBits(size_t limb)
+{
+    return ((limb & 1U) == 0U) ? 26U : 25U;
+}
+
+void FieldSet(FieldElement& out, int32_t value)
+{
+    std::memset(&out, 0, sizeof(out));
+    out.v[0] = value;
+}
+
+/* The top bit is ignored, values up to 2^255 - 1 are accepted */
+void FieldFromBytes(FieldElement& out, const uint8_t* in)
+{
+    uint64_t bits = 0U;
+    unsigned bitCount = 0U;
+
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        unsigned width = LimbBits(i);
+
+        while (bitCount < width)
+        {
+            bits |= static_cast<uint64_t>(*in++) << bitCount;
+            bitCount += 8U;
+        }
+
+        out.v[i] = static_cast<int32_t>(bits & ((1U << width) - 1U));
+        bits >>= width;
+        bitCount -= width;
+    }
+}
+
+/* Limbs back to 26 / 25 bits plus sign, the top carry wraps around as 2^255 = 19 */
+void FieldCarry(FieldElement& out, int64_t* h)
+{
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        unsigned width = LimbBits(i);
+        int64_t carry = (h[i] + (int64_t{1} << (width - 1U))) >> width;
+
+        h[i] -= carry * (int64_t{1} << width);
+        if (i == 9U)
+        {
+            h[0] += carry * 19;
+        }
+        else
+        {
+            h[i + 1U] += carry;
+        }
+    }
+
+    int64_t carry = (h[0] + (int64_t{1} << 25U)) >> 26U;
+    h[0] -= carry * (int64_t{1} << 26U);
+    h[1] += carry;
+
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        out.v[i] = static_cast<int32_t>(h[i]);
+    }
+}
+
+/* Canonical encoding, fully reduced below 2^255 - 19 */
+void FieldToBytes(uint8_t* out, const FieldElement& in)
+{
+    int64_t h[10];
+    FieldElement carried;
+
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        h[i] = in.v[i];
+    }
+    FieldCarry(carried, h);
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        h[i] = carried.v[i];
+    }
+
+    /* q is 1 if the value is at least 2^255 - 19, adding 19 q and dropping bit 255 subtracts p */
+    int64_t q = ((19 * h[9]) + (int64_t{1} << 24U)) >> 25U;
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        q = (h[i] + q) >> LimbBits(i);
+    }
+    h[0] += 19 * q;
+
+    for (size_t i = 0U; i < 9U; i++)
+    {
+        int64_t carry = h[i] >> LimbBits(i);
+        h[i] -= carry * (int64_t{1} << LimbBits(i));
+        h[i + 1U] += carry;
+    }
+    h[9] &= (int64_t{1} << 25U) - 1;
+
+    uint64_t bits = 0U;
+    unsigned bitCount = 0U;
+
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        bits |= static_cast<uint64_t>(h[i]) << bitCount;
+        bitCount += LimbBits(i);
+
+        while (bitCount >= 8U)
+        {
+            *out++ = static_cast<uint8_t>(bits);
+            bits >>= 8U;
+            bitCount -= 8U;
+        }
+    }
+    *out = static_cast<uint8_t>(bits);
+}
+
+void FieldAdd(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        out.v[i] = a.v[i] + b.v[i];
+    }
+}
+
+void FieldSub(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        out.v[i] = a.v[i] - b.v[i];
+    }
+}
+
+void FieldNeg(FieldElement& out, const FieldElement& a)
+{
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        out.v[i] = -a.v[i];
+    }
+}
+
+/* Schoolbook product. Both limbs odd carry an extra factor of 2, the part above 2^255 folds back
+   times 19, both are applied to b up front. Inputs may be one addition away from carried limbs. */
+void FieldMul(FieldElement& out, const FieldElement& a, const FieldElement& b)
+{
+    int64_t bEven[20];
+    int64_t bOdd[20];
+    int64_t h[10] = {};
+
+    for (size_t j = 0U; j < 10U; j++)
+    {
+        bEven[j] = b.v[j];
+        bOdd[j] = ((j & 1U) != 0U) ? 2 * bEven[j] : bEven[j];
+        bEven[j + 10U] = 19 * bEven[j];
+        bOdd[j + 10U] = 19 * bOdd[j];
+    }
+
+    for (size_t i = 0U; i < 10U; i++)
+    {
+        const int64_t* bScaled = ((i & 1U) != 0U) ? bOdd : bEven;
+        int64_t ai = a.v[i];
+
+        for (size_t j = 0U; j < 10U - i; j++)
+        {
+            h[i + j] += ai * bScaled[j];
+        }
+        for (size_t j = 10U - i; j < 10U; j++)
+        {
+            h[i + j - 10U] += ai * bScaled[j + 10U];
+        }
+    }
+
+    FieldCarry(out, h);
+}
+
+void FieldSquare(FieldElement& out, const FieldElement& a, size_t times = 1U)
+{
+    out = a;
+    for (size_t i = 0U; i < times; i++)
+    {
+        FieldMul(out, out, out);
+    }
+}
+
+/* Common head of inversion and square root: z^(2^250 - 1) and z^11 */
+void FieldPow2250(FieldElement& z2_250_0, FieldElement& z11, const FieldElement& z)
+{
+    FieldElement z2, z9, t, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0;
+
+    FieldSquare(z2, z);
+    FieldSquare(t, z2, 2U);
+    FieldMul(z9, t, z);
+    FieldMul(z11, z9, z2);
+    FieldSquare(t, z11);
+    FieldMul(z2_5_0, t, z9);
+    FieldSquare(t, z2_5_0, 5U);
+    FieldMul(z2_10_0, t, z2_5_0);
+    FieldSquare(t, z2_10_0, 10U);
+    FieldMul(z2_20_0, t, z2_10_0);
+    FieldSquare(t, z2_20_0, 20U);
+    FieldMul(t, t, z2_20_0);
+    FieldSquare(t, t, 10U);
+    FieldMul(z2_50_0, t, z2_10_0);
+    FieldSquare(t, z2_50_0, 50U);
+    FieldMul(z2_100_0, t, z2_50_0);
+    FieldSquare(t, z2_100_0, 100U);
+    FieldMul(t, t, z2_100_0);
+    FieldSquare(t, t, 50U);
+    FieldMul(z2_250_0, t, z2_50_0);
+}
+
+/* z^(p - 2) */
+void FieldInvert(FieldElement& out, const FieldElement& z)
+{
+    FieldElement t, z11;
+
+    FieldPow2250(t, z11, z);
+    FieldSquare(t, t, 5U);
+    FieldMul(out, t, z11);
+}
+
+/* z^((p - 5) / 8) */
+void FieldPow22523(FieldElement& out, const FieldElement& z)
+{
+    FieldElement t, z11;
+
+    FieldPow2250(t, z11, z);
+    FieldSquare(t, t, 2U);
+    FieldMul(out, t, z);
+}
+
+bool FieldIsZero(const FieldElement& a)
+{
+    uint8_t bytes[fieldSize];
+    uint8_t bits = 0U;
+
+    FieldToBytes(bytes, a);
+    for (uint8_t byte : bytes)
+    {
+        bits |= byte;
+    }
+
+    return bits == 0U;
+}
+
+bool FieldIsNegative(const FieldElement& a)
+{
+    uint8_t bytes[fieldSize];
+
+    FieldToBytes(bytes, a);
+    return (bytes[0] & 1U) != 0U;
+}
+
+void PointIdentity(Point& p)
+{
+    FieldSet(p.X, 0);
+    FieldSet(p.Y, 1);
+    FieldSet(p.Z, 1);
+    FieldSet(p.T, 0);
+}
+
+/* RFC 8032 5.1.3, non-canonical y is rejected */
+bool PointDecode(Point& p, const uint8_t* in)
+{
+    FieldElement u, v, v3, vxx, check, d;
+    uint8_t canonical[fieldSize];
+    bool negative = (in[fieldSize - 1U] & 0x80U) != 0U;
+
+    FieldFromBytes(p.Y, in);
+    FieldToBytes(canonical, p.Y);
+    canonical[fieldSize - 1U] |= in[fieldSize - 1U] & 0x80U;
+    if (std::memcmp(canonical, in, fieldSize) != 0)
+    {
+        return false;
+    }
+
+    /* x^2 = u / v with u = y^2 - 1 and v = d y^2 + 1 */
+    FieldSet(p.Z, 1);
+    FieldFromBytes(d, curveD);
+    FieldSquare(u, p.Y);
+    FieldMul(v, u, d);
+    FieldSub(u, u, p.Z);
+    FieldAdd(v, v, p.Z);
+
+    /* x = u v^3 (u v^7)^((p - 5) / 8) */
+    FieldSquare(v3, v);
+    FieldMul(v3, v3, v);
+    FieldSquare(p.X, v3);
+    FieldMul(p.X, p.X, v);
+    FieldMul(p.X, p.X, u);
+    FieldPow22523(p.X, p.X);
+    FieldMul(p.X, p.X, v3);
+    FieldMul(p.X, p.X, u);
+
+    FieldSquare(vxx, p.X);
+    FieldMul(vxx, vxx, v);
+    FieldSub(check, vxx, u);
+    if (!FieldIsZero(check))
+    {
+        FieldAdd(check, vxx, u);
+        if (!FieldIsZero(check))
+        {
+            return false;
+        }
+
+        FieldElement root;
+        FieldFromBytes(root, sqrtMinusOne);
+        FieldMul(p.X, p.X, root);
+    }
+
+    if (FieldIsZero(p.X) && negative)
+    {
+        return false;
+    }
+
+    if (FieldIsNegative(p.X) != negative)
+    {
+        FieldNeg(p.X, p.X);
+    }
+
+    FieldMul(p.T, p.X, p.Y);
+    return true;
+}
+
+void PointEncode(uint8_t* out, const Point& p)
+{
+    FieldElement zInverse, x, y;
+
+    FieldInvert(zInverse, p.Z);
+    FieldMul(x, p.X, zInverse);
+    FieldMul(y, p.Y, zInverse);
+    FieldToBytes(out, y);
+    out[fieldSize - 1U] ^= static_cast<uint8_t>(FieldIsNegative(x) ? 0x80U : 0x00U);
+}
+
+void PointToCached(CachedPoint& out, const Point& p)
+{
+    FieldElement d2;
+
+    FieldFromBytes(d2, curve2D);
+    FieldAdd(out.YplusX, p.Y, p.X);
+    FieldSub(out.YminusX, p.Y, p.X);
+    out.Z = p.Z;
+    FieldMul(out.T2d, p.T, d2);
+}
+
+/* add-2008-hwcd-3 for a = -1, subtracts q if negate is set */
+void PointAdd(Point& out, const Point& p, const CachedPoint& q, bool negate)
+{
+    FieldElement a, b, c, d, e, f, g, h;
+
+    FieldSub(a, p.Y, p.X);
+    FieldMul(a, a, negate ? q.YplusX : q.YminusX);
+    FieldAdd(b, p.Y, p.X);
+    FieldMul(b, b, negate ? q.YminusX : q.YplusX);
+    FieldMul(c, p.T, q.T2d);
+    FieldMul(d, p.Z, q.Z);
+    FieldAdd(d, d, d);
+
+    FieldSub(e, b, a);
+    FieldAdd(h, b, a);
+    if (negate)
+    {
+        FieldAdd(f, d, c);
+        FieldSub(g, d, c);
+    }
+    else
+    {
+        FieldSub(f, d, c);
+        FieldAdd(g, d, c);
+    }
+
+    FieldMul(out.X, e, f);
+    FieldMul(out.Y, g, h);
+    FieldMul(out.T, e, h);
+    FieldMul(out.Z, f, g);
+}
+
+/* dbl-2008-hwcd for a = -1 */
+void PointDouble(Point& out, const Point& p)
+{
+    FieldElement a, b, c, e, f, g, h;
+
+    FieldSquare(a, p.X);
+    FieldSquare(b, p.Y);
+    FieldSquare(c, p.Z);
+    FieldAdd(c, c, c);
+    FieldAdd(h, a, b);
+    FieldAdd(e, p.X, p.Y);
+    FieldSquare(e, e);
+    FieldSub(e, h, e);
+    FieldSub(g, a, b);
+    FieldAdd(f, c, g);
+
+    FieldMul(out.X, e, f);
+    FieldMul(out.Y, g, h);
+    FieldMul(out.T, e, h);
+    FieldMul(out.Z, f, g);
+}
+
+/* P, 3P, 5P, ... 15P */
+void PointOddMultiples(CachedPoint* table, const Point& p)
+{
+    Point doubled, sum = p;
+    CachedPoint doubledCached;
+
+    PointDouble(doubled, p);
+    PointToCached(doubledCached, doubled);
+    PointToCached(table[0], p);
+
+    for (size_t i = 1U; i < windowEntries; i++)
+    {
+        PointAdd(sum, sum, doubledCached, false);
+        PointToCached(table[i], sum);
+    }
+}
+
+/* Signed odd digits up to +-15, at least five zeros between two non-zero digits */
+void ScalarSlide(int8_t* digits, const uint8_t* scalar)
+{
+    for (size_t i = 0U; i < scalarBits; i++)
+    {
+        digits[i] = static_cast<int8_t>((scalar[i >> 3U] >> (i & 7U)) & 1U);
+    }
+
+    for (size_t i = 0U; i < scalarBits; i++)
+    {
+        if (digits[i] == 0)
+        {
+            continue;
+        }
+
+        for (size_t b = 1U; (b <= 6U) && (i + b < scalarBits); b++)
+        {
+            if (digits[i + b] == 0)
+            {
+                continue;
+            }
+
+            int shifted = digits[i + b] << b;
+
+            if (digits[i] + shifted <= 15)
+            {
+                digits[i] = static_cast<int8_t>(digits[i] + shifted);
+                digits[i + b] = 0;
+            }
+            else if (digits[i] - shifted >= -15)
+            {
+                digits[i] = static_cast<int8_t>(digits[i] - shifted);
+                for (size_t k = i + b; k < scalarBits; k++)
+                {
+                    if (digits[k] == 0)
+                    {
+                        digits[k] = 1;
+                        break;
+                    }
+                    digits[k] = 0;
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+}
+
+/* out = [a]A + [b]B */
+void DoubleScalarMultiply(Point& out, const uint8_t* a, const Point& A, const uint8_t* b, const Point& B)
+{
+    int8_t aDigits[scalarBits];
+    int8_t bDigits[scalarBits];
+    CachedPoint aTable[windowEntries];
+    CachedPoint bTable[windowEntries];
+
+    ScalarSlide(aDigits, a);
+    ScalarSlide(bDigits, b);
+    PointOddMultiples(aTable, A);
+    PointOddMultiples(bTable, B);
+    PointIdentity(out);
+
+    size_t i = scalarBits;
+    while ((i > 0U) && (aDigits[i - 1U] == 0) && (bDigits[i - 1U] == 0))
+    {
+        i--;
+    }
+
+    while (i-- > 0U)
+    {
+        PointDouble(out, out);
+
+        if (aDigits[i] != 0)
+        {
+            PointAdd(out, out, aTable[(aDigits[i] > 0 ? aDigits[i] : -aDigits[i]) / 2], aDigits[i] < 0);
+        }
+
+        if (bDigits[i] != 0)
+        {
+            PointAdd(out, out, bTable[(bDigits[i] > 0 ? bDigits[i] : -bDigits[i]) / 2], bDigits[i] < 0);
+        }
+    }
+}
+
+/* 512 bit little-endian value modulo L */
+void ScalarReduce(uint8_t* out, const uint8_t* in)
+{
+    int64_t x[64];
+
+    for (size_t i = 0U; i < 64U; i++)
+    {
+        x[i] = in[i];
+    }
+
+    /* Fold every byte above 2^256 down with 2^252 = -(L - 2^252) mod L, 16 * 2^248 being 2^252 */
+    for (size_t i = 63U; i >= 32U; i--)
+    {
+        int64_t carry = 0;
+        size_t j;
+
+        for (j = i - 32U; j < i - 12U; j++)
+        {
+            x[j] += carry - 16 * x[i] * groupOrder[j - (i - 32U)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+
+    int64_t carry = 0;
+    for (size_t j = 0U; j < 32U; j++)
+    {
+        x[j] += carry - (x[31] >> 4) * groupOrder[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+
+    for (size_t j = 0U; j < 32U; j++)
+    {
+        x[j] -= carry * groupOrder[j];
+    }
+
+    for (size_t i = 0U; i < 32U; i++)
+    {
+        x[i + 1U] += x[i] >> 8;
+        out[i] = static_cast<uint8_t>(x[i] & 255);
+    }
+}
+
+/* S must be below L, otherwise S + L would be a second valid signature */
+bool ScalarIsCanonical(const uint8_t* scalar)
+{
+    for (size_t i = fieldSize; i-- > 0U;)
+    {
+        if (scalar[i] != groupOrder[i])
+        {
+            return scalar[i] < groupOrder[i];
+        }
+    }
+
+    return false;
+}
+
+bool HashChallenge(uint8_t* challenge, const uint8_t* r, const uint8_t* publicKey, const uint8_t* message,
+                   size_t messageSize)
+{
+    uint8_t digest[64];
+    mbedtls_sha512_context ctx;
+
+    mbedtls_sha512_init(&ctx);
+    bool ok = (mbedtls_sha512_starts(&ctx, 0) == 0) && (mbedtls_sha512_update(&ctx, r, fieldSize) == 0)
+              && (mbedtls_sha512_update(&ctx, publicKey, Ed25519::publicKeySize) == 0)
+              && (mbedtls_sha512_update(&ctx, message, messageSize) == 0) && (mbedtls_sha512_finish(&ctx, digest) == 0);
+    mbedtls_sha512_free(&ctx);
+
+    if (ok)
+    {
+        ScalarReduce(challenge, digest);
+    }
+
+    return ok;
+}
+} // namespace
+
+Ed25519::RetStatus Ed25519::Verify(const uint8_t* publicKey, const uint8_t* message, size_t messageSize,
+                                   const uint8_t* signature)
+{
+    const uint8_t* r = signature;
+    const uint8_t* s = signature + fieldSize;
+    uint8_t challenge[fieldSize];
+    uint8_t encoded[fieldSize];
+    Point A, B, check;
+
+    if (!ScalarIsCanonical(s))
+    {
+        return RetStatus::invalidSignature;
+    }
+
+    if (!PointDecode(A, publicKey) || !PointDecode(B, basePoint))
+    {
+        return RetStatus::invalidKey;
+    }
+
+    if (!HashChallenge(challenge, r, publicKey, message, messageSize))
+    {
+        return RetStatus::hashError;
+    }
+
+    /* [S]B - [k]A has to encode to R */
+    FieldNeg(A.X, A.X);
+    FieldNeg(A.T, A.T);
+    DoubleScalarMultiply(check, challenge, A, s, B);
+    PointEncode(encoded, check);
+
+    return (std::memcmp(encoded, r, fieldSize) == 0) ? RetStatus::valid : RetStatus::invalidSignature;
+}
+
+#endif /* ED25519_FIRMWARE_VALIDATION */
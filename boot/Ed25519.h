@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* Ed25519 signature verification (RFC 8032) without heap. Field elements use ten limbs of 26 and 25
+   bits, [S]B - [k]A is evaluated with signed sliding windows over both scalars at once. Only public
+   data is processed, the field arithmetic has no data dependent branches anyway. Uses about 3 KB of
+   stack for the tables of odd multiples. */
+class Ed25519
+{
+  public:
+    enum class RetStatus
+    {
+        valid,
+        invalidKey,
+        invalidSignature,
+        hashError
+    };
+
+    static constexpr size_t publicKeySize = 32U;
+    static constexpr size_t signatureSize = 64U;
+
+    static RetStatus Verify(const uint8_t* publicKey, const uint8_t* message, size_t messageSize,
+                            const uint8_t* signature);
+};
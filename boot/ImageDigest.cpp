@@ -0,0 +1,49 @@
+#include "ImageDigest.h"
+
+static_assert(ImageDigest::digestSize == SecureBoot::hashSize, "The signature backends take a 32 byte digest");
+
+#if (IMAGE_DIGEST_BLAKE2S == 1)
+
+bool ImageDigest::Start()
+{
+    context_.Start();
+    return true;
+}
+
+bool ImageDigest::Update(const uint8_t* data, size_t size)
+{
+    context_.Update(data, size);
+    return true;
+}
+
+bool ImageDigest::Finish(uint8_t* digest)
+{
+    context_.Finish(digest);
+    return true;
+}
+
+#else
+
+bool ImageDigest::Start()
+{
+    return context_.Start() == SecureBoot::RetStatus::valid;
+}
+
+bool ImageDigest::Update(const uint8_t* data, size_t size)
+{
+    return context_.Update(data, size) == SecureBoot::RetStatus::valid;
+}
+
+bool ImageDigest::Finish(uint8_t* digest)
+{
+    return context_.Finish(digest) == SecureBoot::RetStatus::valid;
+}
+
+#endif /* IMAGE_DIGEST_BLAKE2S */
+
+bool ImageDigest::Calculate(const uint8_t* data, size_t size, uint8_t* digest)
+{
+    ImageDigest context;
+
+    return context.Start() && context.Update(data, size) && context.Finish(digest);
+}
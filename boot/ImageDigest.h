@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "BootConfig.h"
+#include "SecureBoot.h"
+#if (IMAGE_DIGEST_BLAKE2S == 1)
+#include "Blake2s.h"
+#endif
+
+/* Digest of the application image that the signature covers, SHA-256 or BLAKE2s-256 as selected with
+   IMAGE_DIGEST_BLAKE2S. Both are 32 bytes, the signature schemes take it as their message hash. */
+class ImageDigest
+{
+  public:
+    static constexpr size_t digestSize = 32U;
+
+    bool Start();
+    bool Update(const uint8_t* data, size_t size);
+    bool Finish(uint8_t* digest);
+
+    static bool Calculate(const uint8_t* data, size_t size, uint8_t* digest);
+
+  private:
+#if (IMAGE_DIGEST_BLAKE2S == 1)
+    Blake2s context_;
+#else
+    SecureBoot::Sha256Context context_;
+#endif
+};
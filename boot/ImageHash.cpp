@@ -0,0 +1,81 @@
+#include "ImageHash.h"
+#include <algorithm>
+#include <cstring>
+
+void ImageHash::Start()
+{
+    active_ = context_.Start();
+    empty_ = true;
+}
+
+void ImageHash::Stop()
+{
+    active_ = false;
+}
+
+bool ImageHash::Advance(uint32_t address)
+{
+    if (active_ && empty_)
+    {
+        startAddress_ = address;
+        nextAddress_ = address;
+        empty_ = false;
+    }
+    else if (active_ && (address < nextAddress_))
+    {
+        active_ = false;
+    }
+    else if (active_ && (address > nextAddress_))
+    {
+        /* Nothing is written into the gap, it stays erased */
+        HashPattern(0xFFU, address - nextAddress_);
+        nextAddress_ = address;
+    }
+
+    return active_;
+}
+
+void ImageHash::HashPattern(uint8_t pattern, size_t size)
+{
+    uint8_t block[64];
+    std::memset(block, pattern, sizeof(block));
+
+    while (active_ && (size > 0U))
+    {
+        size_t chunk = std::min(size, sizeof(block));
+        active_ = context_.Update(block, chunk);
+        size -= chunk;
+    }
+}
+
+void ImageHash::Add(uint32_t address, const uint8_t* data, size_t size)
+{
+    if (Advance(address))
+    {
+        active_ = context_.Update(data, size);
+        nextAddress_ += size;
+    }
+}
+
+void ImageHash::AddFill(uint32_t address, uint8_t pattern, size_t size)
+{
+    if (Advance(address))
+    {
+        HashPattern(pattern, size);
+        nextAddress_ += size;
+    }
+}
+
+bool ImageHash::Finish(uint32_t startAddress, uint32_t endAddress, uint8_t* hash)
+{
+    bool matches = active_ && !empty_ && (startAddress_ == startAddress) && (nextAddress_ <= endAddress);
+
+    if (matches)
+    {
+        HashPattern(0xFFU, endAddress - nextAddress_);
+        matches = active_ && context_.Finish(hash);
+    }
+
+    active_ = false;
+    return matches;
+}
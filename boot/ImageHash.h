@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "ImageDigest.h"
+
+/* ImageDigest of the application built up while it is programmed, so validateFlash does not have to read
+   the whole image back. Data has to arrive in ascending address order, a gap is hashed as erased
+   flash. Anything written below data already hashed invalidates the hash, the caller then hashes the
+   flash contents instead. */
+class ImageHash
+{
+  public:
+    void Start();
+    void Stop();
+    void Add(uint32_t address, const uint8_t* data, size_t size);
+    void AddFill(uint32_t address, uint8_t pattern, size_t size);
+    /* False unless everything hashed covers exactly [startAddress, endAddress), apart from erased flash at the end */
+    bool Finish(uint32_t startAddress, uint32_t endAddress, uint8_t* hash);
+
+  private:
+    ImageDigest context_;
+    bool active_{false};
+    bool empty_{true};
+    uint32_t startAddress_{0U};
+    uint32_t nextAddress_{0U};
+
+    bool Advance(uint32_t address);
+    void HashPattern(uint8_t pattern, size_t size);
+};
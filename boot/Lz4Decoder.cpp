@@ -0,0 +1,84 @@
+#include "Lz4Decoder.h"
+#include <cstring>
+
+bool Lz4Decoder::ReadLength(const uint8_t*& source, const uint8_t* sourceEnd, size_t& length)
+{
+    /* A nibble of 15 is continued by bytes, each 255 means another byte follows */
+    uint8_t value;
+
+    do
+    {
+        if (source >= sourceEnd)
+        {
+            return false;
+        }
+        value = *source++;
+        length += value;
+    } while (value == 255U);
+
+    return true;
+}
+
+Lz4Decoder::RetStatus Lz4Decoder::Decode(const uint8_t* source, size_t sourceSize, uint8_t* destination,
+                                         size_t capacity, size_t& decodedSize)
+{
+    const uint8_t* sourceEnd = source + sourceSize;
+    size_t position = 0U;
+
+    while (source < sourceEnd)
+    {
+        uint8_t token = *source++;
+
+        size_t literalLength = token >> 4U;
+        if ((literalLength == 15U) && !ReadLength(source, sourceEnd, literalLength))
+        {
+            return RetStatus::eNotOk;
+        }
+
+        if ((literalLength > static_cast<size_t>(sourceEnd - source)) || (literalLength > capacity - position))
+        {
+            return RetStatus::eNotOk;
+        }
+
+        std::memcpy(&destination[position], source, literalLength);
+        source += literalLength;
+        position += literalLength;
+
+        /* The last sequence of a block carries literals only */
+        if (source == sourceEnd)
+        {
+            break;
+        }
+
+        if (sourceEnd - source < 2)
+        {
+            return RetStatus::eNotOk;
+        }
+
+        size_t offset = static_cast<size_t>(source[0]) | (static_cast<size_t>(source[1]) << 8U);
+        source += 2U;
+
+        size_t matchLength = token & 0x0FU;
+        if ((matchLength == 15U) && !ReadLength(source, sourceEnd, matchLength))
+        {
+            return RetStatus::eNotOk;
+        }
+        matchLength += minMatchLength;
+
+        if ((offset == 0U) || (offset > position) || (matchLength > capacity - position))
+        {
+            return RetStatus::eNotOk;
+        }
+
+        /* Byte by byte on purpose, a match may overlap the bytes it produces */
+        const uint8_t* match = &destination[position - offset];
+        for (size_t i = 0U; i < matchLength; ++i)
+        {
+            destination[position + i] = match[i];
+        }
+        position += matchLength;
+    }
+
+    decodedSize = position;
+    return RetStatus::eOk;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* Decoder for the LZ4 block format (no frame header, no checksum). Every compressed packet is an
+   independent block, so the only state is the output buffer the matches refer back into. */
+class Lz4Decoder
+{
+  public:
+    enum class RetStatus
+    {
+        eOk,
+        eNotOk
+    };
+
+    RetStatus Decode(const uint8_t* source, size_t sourceSize, uint8_t* destination, size_t capacity,
+                     size_t& decodedSize);
+
+  private:
+    static constexpr size_t minMatchLength = 4U;
+
+    bool ReadLength(const uint8_t*& source, const uint8_t* sourceEnd, size_t& length);
+};
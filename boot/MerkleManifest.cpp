@@ -0,0 +1,246 @@
+#include "MerkleManifest.h"
+#include <algorithm>
+#include <cstring>
+
+/* Domain separation of RFC 6962, a leaf can never be taken for a node */
+constexpr uint8_t leafPrefix = 0x00U;
+constexpr uint8_t nodePrefix = 0x01U;
+
+void MerkleManifest::Reset()
+{
+    startAddress_ = 0U;
+    endAddress_ = 0U;
+    blockSizeLog2_ = 0U;
+    blockCount_ = 0U;
+    leafCount_ = 0U;
+    authenticated_ = false;
+    written_.reset();
+    ClearVerified();
+}
+
+MerkleManifest::RetStatus MerkleManifest::Configure(uint32_t startAddress, uint32_t endAddress, uint8_t blockSizeLog2)
+{
+    if ((blockSizeLog2 < minBlockSizeLog2) || (blockSizeLog2 > maxBlockSizeLog2) || (startAddress >= endAddress))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    size_t blockCount = ((endAddress - startAddress - 1U) >> blockSizeLog2) + 1U;
+
+    if (blockCount > BootConfig::maxManifestBlocks)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    if ((startAddress != startAddress_) || (endAddress != endAddress_) || (blockSizeLog2 != blockSizeLog2_))
+    {
+        Reset();
+        startAddress_ = startAddress;
+        endAddress_ = endAddress;
+        blockSizeLog2_ = blockSizeLog2;
+        blockCount_ = blockCount;
+    }
+
+    return RetStatus::eOk;
+}
+
+MerkleManifest::RetStatus MerkleManifest::AddLeaves(size_t firstLeaf, const uint8_t* leaves, size_t size)
+{
+    size_t count = size / ImageDigest::digestSize;
+
+    /* Authenticated leaves must not change anymore */
+    if (authenticated_ || ((size % ImageDigest::digestSize) != 0U) || (firstLeaf != leafCount_)
+        || (count > blockCount_ - leafCount_))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    std::memcpy(leaves_[firstLeaf], leaves, size);
+    leafCount_ += count;
+    return RetStatus::eOk;
+}
+
+size_t MerkleManifest::GetBlockCount() const
+{
+    return blockCount_;
+}
+
+bool MerkleManifest::IsComplete() const
+{
+    return (blockCount_ != 0U) && (leafCount_ == blockCount_);
+}
+
+bool MerkleManifest::CalculateRoot(uint8_t* root) const
+{
+    return IsComplete() && CalculateSubtree(0U, blockCount_, root);
+}
+
+void MerkleManifest::SetAuthenticated()
+{
+    authenticated_ = true;
+    written_.reset();
+    ClearVerified();
+}
+
+void MerkleManifest::Add(uint32_t address, size_t size)
+{
+    uint32_t endAddress = address + static_cast<uint32_t>(size);
+
+    if (!authenticated_ || (endAddress <= startAddress_) || (address >= endAddress_))
+    {
+        return;
+    }
+
+    address = std::max(address, startAddress_);
+    endAddress = std::min(endAddress, endAddress_);
+
+    while (address < endAddress)
+    {
+        size_t block = (address - startAddress_) >> blockSizeLog2_;
+        uint32_t blockStart = startAddress_ + (static_cast<uint32_t>(block) << blockSizeLog2_);
+        uint32_t blockEnd = GetBlockEnd(block);
+        size_t chunk = std::min(endAddress, blockEnd) - address;
+
+        if ((block != currentBlock_) || (address != nextAddress_))
+        {
+            /* Anything but the continuation of the block being followed, including a second write into a
+               block already verified, leaves the block to VerifyImage */
+            currentBlock_ = noBlock;
+            pending_.reset(block);
+            verified_.reset(block);
+
+            if ((address == blockStart) && !written_.test(block))
+            {
+                currentBlock_ = block;
+                nextAddress_ = address;
+            }
+        }
+        written_.set(block);
+
+        if (currentBlock_ == block)
+        {
+            nextAddress_ += chunk;
+
+            if (nextAddress_ == blockEnd)
+            {
+                currentBlock_ = noBlock;
+                pending_.set(block);
+            }
+        }
+
+        address += chunk;
+    }
+}
+
+bool MerkleManifest::HasPendingBlocks() const
+{
+    return pending_.any();
+}
+
+bool MerkleManifest::VerifyPending()
+{
+    bool matches = true;
+
+    /* Hashed from flash, not from the received data, so a write that went wrong is never taken as verified */
+    for (size_t block = 0U; block < blockCount_; ++block)
+    {
+        uint8_t leaf[ImageDigest::digestSize];
+
+        if (!pending_.test(block))
+        {
+            continue;
+        }
+
+        if (HashBlock(block, leaf) && (std::memcmp(leaf, leaves_[block], sizeof(leaf)) == 0))
+        {
+            verified_.set(block);
+        }
+        else
+        {
+            matches = false;
+        }
+    }
+
+    pending_.reset();
+    return matches;
+}
+
+void MerkleManifest::ClearVerified()
+{
+    pending_.reset();
+    verified_.reset();
+    currentBlock_ = noBlock;
+}
+
+bool MerkleManifest::VerifyImage(uint32_t startAddress, uint32_t endAddress, uint8_t blockSizeLog2,
+                                 const uint8_t* root)
+{
+    bool session = authenticated_ && (startAddress == startAddress_) && (endAddress == endAddress_)
+        && (blockSizeLog2 == blockSizeLog2_);
+    uint8_t calculated[ImageDigest::digestSize];
+    bool valid = true;
+
+    if (!session)
+    {
+        if (Configure(startAddress, endAddress, blockSizeLog2) != RetStatus::eOk)
+        {
+            return false;
+        }
+        ClearVerified();
+    }
+
+    /* Only blocks not verified while they were programmed are read back */
+    for (size_t block = 0U; valid && (block < blockCount_); ++block)
+    {
+        if (!verified_.test(block))
+        {
+            valid = HashBlock(block, leaves_[block]);
+        }
+    }
+
+    leafCount_ = blockCount_;
+    valid = valid && CalculateSubtree(0U, blockCount_, calculated)
+        && (std::memcmp(calculated, root, sizeof(calculated)) == 0);
+
+    /* On a mismatch the leaves no longer are the authenticated ones */
+    authenticated_ = session && valid;
+    return valid;
+}
+
+bool MerkleManifest::CalculateSubtree(size_t first, size_t count, uint8_t* digest) const
+{
+    if (count == 1U)
+    {
+        std::memcpy(digest, leaves_[first], ImageDigest::digestSize);
+        return true;
+    }
+
+    /* The left subtree holds the largest power of two below count, the depth stays below 8 */
+    size_t split = 1U;
+    while (split * 2U < count)
+    {
+        split *= 2U;
+    }
+
+    uint8_t children[2U][ImageDigest::digestSize];
+    ImageDigest context;
+
+    return CalculateSubtree(first, split, children[0]) && CalculateSubtree(first + split, count - split, children[1])
+        && context.Start() && context.Update(&nodePrefix, sizeof(nodePrefix))
+        && context.Update(&children[0][0], sizeof(children)) && context.Finish(digest);
+}
+
+bool MerkleManifest::HashBlock(size_t block, uint8_t* leaf) const
+{
+    uint32_t blockStart = startAddress_ + (static_cast<uint32_t>(block) << blockSizeLog2_);
+    ImageDigest context;
+
+    return context.Start() && context.Update(&leafPrefix, sizeof(leafPrefix))
+        && context.Update(reinterpret_cast<const uint8_t*>(blockStart), GetBlockEnd(block) - blockStart)
+        && context.Finish(leaf);
+}
+
+uint32_t MerkleManifest::GetBlockEnd(size_t block) const
+{
+    return std::min(startAddress_ + (static_cast<uint32_t>(block + 1U) << blockSizeLog2_), endAddress_);
+}
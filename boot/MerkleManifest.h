@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <bitset>
+#include "ImageDigest.h"
+#include "BootConfig.h"
+
+/* Merkle tree over the application in blocks of 2^blockSizeLog2 bytes (4 to 16 KB), hashed as in
+   RFC 6962 with ImageDigest: a leaf is H(0x00 || block), a node H(0x01 || left || right). The last
+   block ends with the image, gaps are erased flash as for the image digest.
+   The flasher sends the leaves and a signature of the root before the data. Once the root is
+   authenticated, every block whose data arrives in one ascending run is hashed back from flash as
+   soon as it is complete and programmed. Blocks written any other way, or not written at all in this
+   session, are hashed from flash by VerifyImage. */
+class MerkleManifest
+{
+  public:
+    enum class RetStatus
+    {
+        eOk,
+        eNotOk
+    };
+
+    static constexpr uint8_t minBlockSizeLog2 = 12U;
+    static constexpr uint8_t maxBlockSizeLog2 = 14U;
+
+    void Reset();
+    /* Layout of the manifest, leaves received so far are kept as long as it does not change */
+    RetStatus Configure(uint32_t startAddress, uint32_t endAddress, uint8_t blockSizeLog2);
+    /* Leaves in order, firstLeaf has to follow the ones received so far */
+    RetStatus AddLeaves(size_t firstLeaf, const uint8_t* leaves, size_t size);
+    size_t GetBlockCount() const;
+    bool IsComplete() const;
+    bool CalculateRoot(uint8_t* root) const;
+    /* The signature of the root is checked, programmed data is verified from now on */
+    void SetAuthenticated();
+
+    /* Records programmed data, a block it completes is queued for VerifyPending */
+    void Add(uint32_t address, size_t size);
+    bool HasPendingBlocks() const;
+    /* Hashes the queued blocks from flash, their data has to be programmed by now. False if one differs
+       from its leaf. */
+    bool VerifyPending();
+    /* After a failed write the flash may hold anything, every block is left to VerifyImage */
+    void ClearVerified();
+
+    /* Recomputes the root from the blocks verified while programming and the rest hashed from flash */
+    bool VerifyImage(uint32_t startAddress, uint32_t endAddress, uint8_t blockSizeLog2, const uint8_t* root);
+
+  private:
+    static constexpr size_t noBlock = SIZE_MAX;
+
+    uint8_t leaves_[BootConfig::maxManifestBlocks][ImageDigest::digestSize];
+    std::bitset<BootConfig::maxManifestBlocks> written_;
+    std::bitset<BootConfig::maxManifestBlocks> pending_;
+    std::bitset<BootConfig::maxManifestBlocks> verified_;
+    uint32_t startAddress_{0U};
+    uint32_t endAddress_{0U};
+    uint8_t blockSizeLog2_{0U};
+    size_t blockCount_{0U};
+    size_t leafCount_{0U};
+    bool authenticated_{false};
+
+    size_t currentBlock_{noBlock};
+    uint32_t nextAddress_{0U};
+
+    bool CalculateSubtree(size_t first, size_t count, uint8_t* digest) const;
+    bool HashBlock(size_t block, uint8_t* leaf) const;
+    uint32_t GetBlockEnd(size_t block) const;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include "BeeCom.h"
+
+/* Fixed pool of packet buffers handed from the BeeCOM parser to the packet handlers in FIFO order.
+   A received frame is copied into a free slot so the parser can assemble the next one while the
+   handler still works on this one; the slot is returned by Release() once the handler is done. */
+template <size_t slotCount, size_t payloadSize>
+class PacketPool
+{
+  public:
+    bool Store(const beecom::Packet& packet)
+    {
+        if (IsFull() || (packet.header.length > payloadSize))
+        {
+            return false;
+        }
+
+        Slot& slot = slots[head % slotCount];
+        slot.packet = packet;
+        slot.packet.payload = slot.payload;
+        std::memcpy(slot.payload, packet.payload, packet.header.length);
+        ++head;
+
+        return true;
+    }
+
+    const beecom::Packet* Front() const
+    {
+        return IsEmpty() ? nullptr : &slots[tail % slotCount].packet;
+    }
+
+    void Release()
+    {
+        if (!IsEmpty())
+        {
+            ++tail;
+        }
+    }
+
+    bool IsEmpty() const
+    {
+        return head == tail;
+    }
+
+    bool IsFull() const
+    {
+        return (head - tail) == slotCount;
+    }
+
+  private:
+    struct Slot
+    {
+        beecom::Packet packet;
+        uint8_t payload[payloadSize];
+    };
+
+    std::array<Slot, slotCount> slots;
+    size_t head{0U};
+    size_t tail{0U};
+};
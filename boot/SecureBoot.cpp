@@ -1,38 +1,144 @@
 #include "SecureBoot.h"
+#include "BootArena.h"
+#include "ImageDigest.h"
+#include "BootConfig.h"
+#include <cstring>
 
 SecureBoot::SecureBoot()
 {
-    mbedtls_memory_buffer_alloc_init(mbedtlsBuff, sizeof(mbedtlsBuff));
+    if (BootConfig::cryptoHeapSize == 0U)
+    {
+        return;
+    }
+
+    /* The heap is handed back by the BootArena scope of the caller. Without it every mbedtls
+       allocation fails and the check reports an error instead of a valid image. */
+    heap_ = static_cast<unsigned char*>(BootArena::Allocate(BootConfig::cryptoHeapSize));
+
+    if (heap_ != nullptr)
+    {
+        /* Zeroed, so the extent mbedtls wrote to can be found again afterwards */
+        std::memset(heap_, 0, BootConfig::cryptoHeapSize);
+        mbedtls_memory_buffer_alloc_init(heap_, BootConfig::cryptoHeapSize);
+    }
 }
 
 SecureBoot::~SecureBoot()
 {
+    if (heap_ != nullptr)
+    {
+        /* The allocator hands out the lowest free block first and puts a header behind every block it
+           splits off, so the last byte written bounds the peak. The verify phase of BootArena reports
+           it instead of the whole heap, which is what cryptoHeapSize is sized from. */
+        size_t used = BootConfig::cryptoHeapSize;
+        while ((used > 0U) && (heap_[used - 1U] == 0U))
+        {
+            --used;
+        }
+
+        BootArena::Trim(heap_, used);
+    }
+
     mbedtls_memory_buffer_alloc_free();
 }
 
+SecureBoot::Sha256Context::Sha256Context()
+{
+    mbedtls_sha256_init(&ctx);
+}
+
+SecureBoot::Sha256Context::~Sha256Context()
+{
+    mbedtls_sha256_free(&ctx);
+}
+
+SecureBoot::RetStatus SecureBoot::Sha256Context::Start()
+{
+    return (mbedtls_sha256_starts(&ctx, 0) == 0) ? RetStatus::valid : RetStatus::hashCalculationError;
+}
+
+SecureBoot::RetStatus SecureBoot::Sha256Context::Update(const unsigned char* data, size_t data_len)
+{
+    return (mbedtls_sha256_update(&ctx, data, data_len) == 0) ? RetStatus::valid : RetStatus::hashCalculationError;
+}
+
+SecureBoot::RetStatus SecureBoot::Sha256Context::Finish(unsigned char* hash)
+{
+    return (mbedtls_sha256_finish(&ctx, hash) == 0) ? RetStatus::valid : RetStatus::hashCalculationError;
+}
+
+SecureBoot::RetStatus SecureBoot::ValidateFirmware(
+    const unsigned char* signature,
+    size_t sig_len,
+    const unsigned char* data,
+    size_t data_len)
+{
+    unsigned char hash[hashSize];
+    if (!ImageDigest::Calculate(data, data_len, hash))
+    {
+        return RetStatus::hashCalculationError;
+    }
+
+    return ValidateHash(signature, sig_len, hash);
+}
+
 SecureBoot::RetStatus SecureBoot::CalculateSHA256(const unsigned char* data, size_t data_len, unsigned char* hash)
 {
-    mbedtls_sha256_context sha256_ctx;
-    mbedtls_sha256_init(&sha256_ctx);
+    Sha256Context context;
 
-    if (mbedtls_sha256_starts(&sha256_ctx, 0) != 0)
+    if ((context.Start() != RetStatus::valid) || (context.Update(data, data_len) != RetStatus::valid)
+        || (context.Finish(hash) != RetStatus::valid))
     {
-        mbedtls_sha256_free(&sha256_ctx);
         return RetStatus::hashCalculationError;
     }
 
-    if (mbedtls_sha256_update(&sha256_ctx, data, data_len) != 0)
+    return RetStatus::valid;
+}
+
+SecureBoot::RetStatus SecureBoot::CalculateHMAC(const unsigned char* key, size_t key_len, const unsigned char* data,
+                                                size_t data_len, unsigned char* mac)
+{
+    /* HMAC-SHA256 on top of Sha256Context, so it needs no mbedtls heap and works outside a SecureBoot object */
+    constexpr size_t blockSize = 64U;
+    unsigned char keyBlock[blockSize] = {};
+    unsigned char pad[blockSize];
+    unsigned char innerHash[hashSize];
+
+    if (key_len > blockSize)
+    {
+        if (CalculateSHA256(key, key_len, keyBlock) != RetStatus::valid)
+        {
+            return RetStatus::hashCalculationError;
+        }
+    }
+    else
+    {
+        std::memcpy(keyBlock, key, key_len);
+    }
+
+    for (size_t i = 0U; i < blockSize; i++)
+    {
+        pad[i] = keyBlock[i] ^ 0x36U;
+    }
+
+    Sha256Context inner;
+    if ((inner.Start() != RetStatus::valid) || (inner.Update(pad, blockSize) != RetStatus::valid)
+        || (inner.Update(data, data_len) != RetStatus::valid) || (inner.Finish(innerHash) != RetStatus::valid))
     {
-        mbedtls_sha256_free(&sha256_ctx);
         return RetStatus::hashCalculationError;
     }
 
-    if (mbedtls_sha256_finish(&sha256_ctx, hash) != 0)
+    for (size_t i = 0U; i < blockSize; i++)
+    {
+        pad[i] = keyBlock[i] ^ 0x5CU;
+    }
+
+    Sha256Context outer;
+    if ((outer.Start() != RetStatus::valid) || (outer.Update(pad, blockSize) != RetStatus::valid)
+        || (outer.Update(innerHash, hashSize) != RetStatus::valid) || (outer.Finish(mac) != RetStatus::valid))
     {
-        mbedtls_sha256_free(&sha256_ctx);
         return RetStatus::hashCalculationError;
     }
 
-    mbedtls_sha256_free(&sha256_ctx);
     return RetStatus::valid;
 }
@@ -4,11 +4,7 @@ extern "C"
 {
 #include "mbedtls/platform.h"
 #include "mbedtls/rsa.h"
-#include "mbedtls/pk.h"
-#include "mbedtls/md.h"
-#include "mbedtls/ctr_drbg.h"
-#include "mbedtls/entropy.h"
-#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
 #include "mbedtls/memory_buffer_alloc.h"
 }
 
@@ -24,18 +20,39 @@ class SecureBoot
         paddingError
     };
 
+    /* SHA-256 over data handed in piece by piece */
+    class Sha256Context
+    {
+      public:
+        Sha256Context();
+        ~Sha256Context();
+
+        RetStatus Start();
+        RetStatus Update(const unsigned char* data, size_t data_len);
+        RetStatus Finish(unsigned char* hash);
+
+      private:
+        mbedtls_sha256_context ctx;
+    };
+
     SecureBoot();
     virtual ~SecureBoot();
 
-    virtual RetStatus ValidateFirmware(
+    RetStatus ValidateFirmware(
         const unsigned char* signature,
         size_t sig_len,
         const unsigned char* data,
-        size_t data_len) = 0;
+        size_t data_len);
+
+    /* Signature check of an already calculated SHA-256 digest */
+    virtual RetStatus ValidateHash(const unsigned char* signature, size_t sig_len, const unsigned char* hash) = 0;
 
     static const size_t hashSize = 32;
 
-  protected:
-    unsigned char mbedtlsBuff[8192];
-    RetStatus CalculateSHA256(const unsigned char* data, size_t data_len, unsigned char* hash);
+    static RetStatus CalculateSHA256(const unsigned char* data, size_t data_len, unsigned char* hash);
+    static RetStatus CalculateHMAC(const unsigned char* key, size_t key_len, const unsigned char* data, size_t data_len,
+                                   unsigned char* mac);
+
+  private:
+    unsigned char* heap_{nullptr};
 };
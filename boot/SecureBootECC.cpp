@@ -1,55 +1,42 @@
 #include "SecureBootECC.h"
 #include "BootConfig.h"
-#include <string.h>
+
+/* Built only for the selected algorithm, BootConfig holds the key of that one */
+#if (ECC_FIRMWARE_VALIDATION == 1)
 
 SecureBootECC::SecureBootECC() {}
 SecureBootECC::~SecureBootECC() {}
 
-SecureBoot::RetStatus SecureBootECC::ValidateFirmware(
-    const unsigned char* signature,
-    size_t sig_len,
-    const unsigned char* data,
-    size_t data_len)
+SecureBoot::RetStatus SecureBootECC::ValidateHash(const unsigned char* signature, size_t sig_len,
+                                                  const unsigned char* hash)
 {
-    unsigned char hash[hashSize];
-    if (CalculateSHA256(data, data_len, hash) != RetStatus::valid)
-    {
-        return RetStatus::hashCalculationError;
-    }
-
-    mbedtls_pk_context pkCtx;
-    mbedtls_pk_init(&pkCtx);
-
-    size_t publicKeyLen = strlen((const char*)BootConfig::publicKey) + 1;
-    if (mbedtls_pk_parse_public_key(&pkCtx, reinterpret_cast<const uint8_t*>(BootConfig::publicKey), publicKeyLen) != 0)
-    {
-        mbedtls_pk_free(&pkCtx);
-        return RetStatus::publicKeyError;
-    }
-
-    if (mbedtls_pk_can_do(&pkCtx, MBEDTLS_PK_ECKEY) != 1)
-    {
-        return RetStatus::publicKeyError;
-    }
-
+    RetStatus status = RetStatus::valid;
+    mbedtls_ecp_group group;
+    mbedtls_ecp_point publicPoint;
     mbedtls_ecdsa_context ecdsaCtx;
+
+    mbedtls_ecp_group_init(&group);
+    mbedtls_ecp_point_init(&publicPoint);
     mbedtls_ecdsa_init(&ecdsaCtx);
 
-    mbedtls_ecp_keypair* ecp = mbedtls_pk_ec(pkCtx);
-    if (mbedtls_ecdsa_from_keypair(&ecdsaCtx, ecp) != 0)
+    /* The key is the raw point from BootConfig, nothing has to be parsed */
+    if ((mbedtls_ecp_group_load(&group, MBEDTLS_ECP_DP_SECP256R1) != 0)
+        || (mbedtls_ecp_point_read_binary(&group, &publicPoint, BootConfig::publicKey, sizeof(BootConfig::publicKey))
+            != 0)
+        || (mbedtls_ecp_set_public_key(MBEDTLS_ECP_DP_SECP256R1, &ecdsaCtx, &publicPoint) != 0))
     {
-        mbedtls_ecdsa_free(&ecdsaCtx);
-        return RetStatus::publicKeyError;
+        status = RetStatus::publicKeyError;
     }
-
-    if (mbedtls_ecdsa_read_signature(&ecdsaCtx, hash, sizeof(hash), signature, sig_len) != 0)
+    else if (mbedtls_ecdsa_read_signature(&ecdsaCtx, hash, hashSize, signature, sig_len) != 0)
     {
-        mbedtls_ecdsa_free(&ecdsaCtx);
-        return RetStatus::invalidSignature;
+        status = RetStatus::invalidSignature;
     }
 
     mbedtls_ecdsa_free(&ecdsaCtx);
-    mbedtls_pk_free(&pkCtx);
+    mbedtls_ecp_point_free(&publicPoint);
+    mbedtls_ecp_group_free(&group);
 
-    return RetStatus::valid;
+    return status;
 }
+
+#endif /* ECC_FIRMWARE_VALIDATION */
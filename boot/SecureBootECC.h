@@ -1,7 +1,6 @@
 #pragma once
 #include "SecureBoot.h"
 #include "mbedtls/ecdsa.h"
-#include "mbedtls/pk.h"
 
 class SecureBootECC : public SecureBoot
 {
@@ -9,9 +8,5 @@ class SecureBootECC : public SecureBoot
     SecureBootECC();
     ~SecureBootECC();
 
-    RetStatus ValidateFirmware(
-        const unsigned char* signature,
-        size_t sig_len,
-        const unsigned char* data,
-        size_t data_len) override;
+    RetStatus ValidateHash(const unsigned char* signature, size_t sig_len, const unsigned char* hash) override;
 };
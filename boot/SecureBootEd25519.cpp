@@ -0,0 +1,35 @@
+#include "SecureBootEd25519.h"
+#include "BootConfig.h"
+#include "Ed25519.h"
+
+/* Built only for the selected algorithm, BootConfig holds the key of that one */
+#if (ED25519_FIRMWARE_VALIDATION == 1)
+
+static_assert(sizeof(BootConfig::publicKey) == Ed25519::publicKeySize, "publicKey must be a raw Ed25519 key");
+
+SecureBootEd25519::SecureBootEd25519() {}
+SecureBootEd25519::~SecureBootEd25519() {}
+
+SecureBoot::RetStatus SecureBootEd25519::ValidateHash(const unsigned char* signature, size_t sig_len,
+                                                      const unsigned char* hash)
+{
+    /* The signed message is the image digest, so the streamed image hash applies as for ECDSA */
+    if (sig_len != Ed25519::signatureSize)
+    {
+        return RetStatus::invalidSignature;
+    }
+
+    switch (Ed25519::Verify(BootConfig::publicKey, hash, hashSize, signature))
+    {
+        case Ed25519::RetStatus::valid:
+            return RetStatus::valid;
+        case Ed25519::RetStatus::invalidKey:
+            return RetStatus::publicKeyError;
+        case Ed25519::RetStatus::hashError:
+            return RetStatus::hashCalculationError;
+        default:
+            return RetStatus::invalidSignature;
+    }
+}
+
+#endif /* ED25519_FIRMWARE_VALIDATION */
@@ -0,0 +1,11 @@
+#pragma once
+#include "SecureBoot.h"
+
+class SecureBootEd25519 : public SecureBoot
+{
+  public:
+    SecureBootEd25519();
+    ~SecureBootEd25519();
+
+    RetStatus ValidateHash(const unsigned char* signature, size_t sig_len, const unsigned char* hash) override;
+};
@@ -1,51 +1,48 @@
 #include "SecureBootRSA.h"
 #include "BootConfig.h"
-#include <string.h>
+
+/* Built only for the selected algorithm, BootConfig holds the key of that one */
+#if (RSA_FIRMWARE_VALIDATION == 1)
+
+static_assert(sizeof(BootConfig::publicKeyMontgomeryRR) == sizeof(BootConfig::publicKeyModulus),
+              "publicKeyMontgomeryRR has to be generated for publicKeyModulus");
 
 SecureBootRSA::SecureBootRSA() {}
 SecureBootRSA::~SecureBootRSA() {}
 
-SecureBoot::RetStatus SecureBootRSA::ValidateFirmware(
-    const unsigned char* signature,
-    size_t sig_len,
-    const unsigned char* data,
-    size_t data_len)
+SecureBoot::RetStatus SecureBootRSA::ValidateHash(const unsigned char* signature, size_t sig_len,
+                                                  const unsigned char* hash)
 {
-    unsigned char hash[hashSize];
-    if (CalculateSHA256(data, data_len, hash) != RetStatus::valid)
-    {
-        return RetStatus::hashCalculationError;
-    }
-
-    mbedtls_pk_context pkCtx;
-    mbedtls_pk_init(&pkCtx);
-
-    size_t publicKeyLen = strlen((const char*)BootConfig::publicKey) + 1;
-    if (mbedtls_pk_parse_public_key(&pkCtx, reinterpret_cast<const uint8_t*>(BootConfig::publicKey), publicKeyLen) != 0)
+    RetStatus status = RetStatus::valid;
+    mbedtls_rsa_context rsaCtx;
+    mbedtls_rsa_init(&rsaCtx);
+
+    /* N and E straight from BootConfig, nothing has to be parsed */
+    if ((mbedtls_rsa_import_raw(&rsaCtx, BootConfig::publicKeyModulus, sizeof(BootConfig::publicKeyModulus), nullptr,
+                                0U, nullptr, 0U, nullptr, 0U, BootConfig::publicKeyExponent,
+                                sizeof(BootConfig::publicKeyExponent))
+         != 0)
+        || (mbedtls_rsa_complete(&rsaCtx) != 0)
+        /* R^2 mod N goes where mbedtls caches it, so the exponentiation skips the division by N.
+           tools/kernel_bench/rsa_montgomery_check.cpp compares it with the value of mbedtls. */
+        || (mbedtls_mpi_read_binary(&rsaCtx.MBEDTLS_PRIVATE(RN), BootConfig::publicKeyMontgomeryRR,
+                                    sizeof(BootConfig::publicKeyMontgomeryRR))
+            != 0))
     {
-        mbedtls_pk_free(&pkCtx);
-        return RetStatus::publicKeyError;
+        status = RetStatus::publicKeyError;
     }
-
-    if (!mbedtls_pk_can_do(&pkCtx, MBEDTLS_PK_RSA))
-    {
-        mbedtls_pk_free(&pkCtx);
-        return RetStatus::publicKeyError;
-    }
-
-    mbedtls_rsa_context* rsaCtx = mbedtls_pk_rsa(pkCtx);
-    if (mbedtls_rsa_set_padding(rsaCtx, MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA256) != 0)
+    else if (mbedtls_rsa_set_padding(&rsaCtx, MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA256) != 0)
     {
-        mbedtls_pk_free(&pkCtx);
-        return RetStatus::paddingError;
+        status = RetStatus::paddingError;
     }
-
-    if (mbedtls_rsa_pkcs1_verify(rsaCtx, MBEDTLS_MD_SHA256, sizeof(hash), hash, signature) != 0)
+    else if ((sig_len != mbedtls_rsa_get_len(&rsaCtx))
+             || (mbedtls_rsa_pkcs1_verify(&rsaCtx, MBEDTLS_MD_SHA256, hashSize, hash, signature) != 0))
     {
-        mbedtls_pk_free(&pkCtx);
-        return RetStatus::invalidSignature;
+        status = RetStatus::invalidSignature;
     }
 
-    mbedtls_pk_free(&pkCtx);
-    return RetStatus::valid;
+    mbedtls_rsa_free(&rsaCtx);
+    return status;
 }
+
+#endif /* RSA_FIRMWARE_VALIDATION */
@@ -0,0 +1,37 @@
+#include "TransferWindow.h"
+#include <algorithm>
+
+uint8_t TransferWindow::Configure(uint8_t requestedSize, uint8_t maxSize)
+{
+    size = std::min({requestedSize, maxSize, maxWindowSize});
+    base = 0U;
+    receivedMask = 0U;
+
+    return size;
+}
+
+TransferWindow::Result TransferWindow::Accept(uint16_t sequence)
+{
+    uint16_t offset = static_cast<uint16_t>(sequence - base);
+
+    if (offset >= size)
+    {
+        /* Anything up to half the sequence space behind the base has already been delivered */
+        return (offset >= 0x8000U) ? Result::duplicate : Result::outOfWindow;
+    }
+
+    uint32_t bit = 1UL << offset;
+    if ((receivedMask & bit) != 0U)
+    {
+        return Result::duplicate;
+    }
+
+    receivedMask |= bit;
+    while ((receivedMask & 1U) != 0U)
+    {
+        receivedMask >>= 1U;
+        ++base;
+    }
+
+    return Result::accepted;
+}
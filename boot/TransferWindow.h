@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/* Receive-side bookkeeping for sequenced flashData packets. The host may keep up to `size` packets
+   in flight; every packet carries a 16-bit sequence number and is acknowledged with the cumulative
+   base plus a bitmap of packets already received above it, so the host retransmits only the gaps. */
+class TransferWindow
+{
+  public:
+    enum class Result
+    {
+        accepted,
+        duplicate,
+        outOfWindow
+    };
+
+    static constexpr uint8_t maxWindowSize = 32U;
+
+    uint8_t Configure(uint8_t requestedSize, uint8_t maxSize);
+    Result Accept(uint16_t sequence);
+
+    bool IsConfigured() const
+    {
+        return size != 0U;
+    }
+
+    uint16_t GetBase() const
+    {
+        return base;
+    }
+
+    uint32_t GetReceivedMask() const
+    {
+        return receivedMask;
+    }
+
+  private:
+    uint16_t base{0U};
+    uint32_t receivedMask{0U};
+    uint8_t size{0U};
+};
@@ -0,0 +1,8 @@
+#pragma once
+
+/* Signature algorithm of the image. Plain macros without C++, BootMbedtlsConfig.h builds only the mbedtls
+   modules the selected one needs. */
+#define RSA_FIRMWARE_VALIDATION 0
+#define ECC_FIRMWARE_VALIDATION 1
+/* Faster than both and without heap, the flasher signs the image digest with it */
+#define ED25519_FIRMWARE_VALIDATION 0
@@ -1,19 +1,68 @@
 #pragma once
 
-namespace BootConfig {
-#define RSA_FIRMWARE_VALIDATION 0
-#define ECC_FIRMWARE_VALIDATION 1
+#include "BootAlgorithm.h"
 
+namespace BootConfig {
 #define VALIDATE_APP_BEFORE_BOOT 1
+/* Digest of the image the signature covers, 0 SHA-256, 1 BLAKE2s-256 (about twice as fast on the M4).
+   The "Image digest" setting of the flasher has to match. */
+#define IMAGE_DIGEST_BLAKE2S 0
+/* Check the signature in full only once after an update and store a validation record (CRC32 of the
+   image and a device bound MAC). Later boots compare the hardware CRC32 with the record and fall back
+   to the full check if it does not match. 0 checks the signature on every boot.
+   The MAC key is a per-device secret in OTP (validationKeyOtpBlock), until it is provisioned and
+   locked every boot runs the full check. */
+#define FAST_BOOT_VALIDATION 0
 
 constexpr char bootloaderVersion[] = "1.0.0";
 
 constexpr size_t waitForBootActionMs = 50U;
 constexpr size_t actionBootExtensionMs = 10000U;
 
-constexpr char publicKey[] =
-    "-----BEGIN PUBLIC KEY-----\n"
-    "MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEZdR4u/SQRKrNl9jL6AEmgIHMGbA8\n"
-    "5BXcHgySaR+eDLgej9YT87s692Dh3TLNiSJUhdLDH6gcLVkXoewzlFLFRA==\n"
-    "-----END PUBLIC KEY-----\n";
+/* Maximum number of flashDataWindowed packets the host may keep in flight. The whole window has to
+   fit into the reception ring buffer, which keeps receiving while a packet is programmed. */
+constexpr uint8_t maxTransferWindowSize = 8U;
+
+/* Received packets are queued in a pool of buffers while earlier ones are still being handled */
+constexpr size_t packetPoolSlots = 3U;
+constexpr size_t maxPacketPayloadSize = 1024U;
+
+/* Upper bound for the decompressed data of one flashDataCompressed packet, the buffer lives in RAM */
+constexpr size_t maxDecompressedSize = 2048U;
+
+/* Heap of mbedtls during a signature check, Ed25519 works on the stack. The verify phase of BootArena reports
+   what mbedtls really used, set this to BootArena::GetHighWaterMark(BootArena::Phase::verify) after a
+   validateFlash on the target plus some margin. */
+constexpr size_t cryptoHeapSize = (ED25519_FIRMWARE_VALIDATION == 1) ? 0U : 8192U;
+
+/* Decompression and signature check never overlap, so one arena (BootArena) serves both. It follows from the
+   two sizes above. */
+constexpr size_t arenaSize = (cryptoHeapSize > maxDecompressedSize) ? cryptoHeapSize : maxDecompressedSize;
+
+/* Leaves of the signed Merkle manifest (MerkleManifest) are kept in RAM, 32 bytes per block of 4 to
+   16 KB. 64 blocks of 16 KB cover the whole application region. */
+constexpr size_t maxManifestBlocks = 64U;
+
+/* OTP block holding the 32 byte key of the validation record MAC. Program a random key into it for
+   every device during production and lock the block, the bootloader ignores it before that. */
+constexpr uint32_t validationKeyOtpBlock = 0U;
+
+/* After a baud rate change the host has this long to send a probe at the new rate */
+constexpr uint32_t baudRateProbeTimeoutMs = 500U;
+
+/* Public key in raw form, the bootloader does not parse PEM. Generate it from the .pem file with
+   tools/flasher/public_key_header.py or copy it from the Security tab of the flasher. ECC takes
+   publicKey (Ed25519 the 32 byte key of RFC 8032), RSA publicKeyModulus, publicKeyExponent and
+   publicKeyMontgomeryRR. */
+/* SECP256R1 point, 0x04 || X || Y. ECDSA builds the comb table of this point on the heap for every verify.
+   A table precomputed into flash next to the key is not done: mbedtls only takes precomputed tables for
+   the generator of a curve, it would need a patched ecp.c. */
+constexpr uint8_t publicKey[] = {
+    0x04U, 0x65U, 0xD4U, 0x78U, 0xBBU, 0xF4U, 0x90U, 0x44U, 0xAAU, 0xCDU, 0x97U, 0xD8U,
+    0xCBU, 0xE8U, 0x01U, 0x26U, 0x80U, 0x81U, 0xCCU, 0x19U, 0xB0U, 0x3CU, 0xE4U, 0x15U,
+    0xDCU, 0x1EU, 0x0CU, 0x92U, 0x69U, 0x1FU, 0x9EU, 0x0CU, 0xB8U, 0x1EU, 0x8FU, 0xD6U,
+    0x13U, 0xF3U, 0xBBU, 0x3AU, 0xF7U, 0x60U, 0xE1U, 0xDDU, 0x32U, 0xCDU, 0x89U, 0x22U,
+    0x54U, 0x85U, 0xD2U, 0xC3U, 0x1FU, 0xA8U, 0x1CU, 0x2DU, 0x59U, 0x17U, 0xA1U, 0xECU,
+    0x33U, 0x94U, 0x52U, 0xC5U, 0x44U,
+};
 }; // namespace BootConfig
@@ -1,6 +1,8 @@
 #ifndef BOOT_MBEDTLS_CONFIG_H
 #define BOOT_MBEDTLS_CONFIG_H
 
+#include "BootAlgorithm.h"
+
 #define MBEDTLS_PLATFORM_C
 #define MBEDTLS_PLATFORM_MEMORY
 #define MBEDTLS_PLATFORM_NO_STD_FUNCTIONS
@@ -10,6 +12,13 @@
 
 #define MBEDTLS_SHA224_C
 #define MBEDTLS_SHA256_C
+/* Unrolled SHA-256 compression for Cortex-M4 (portable/STM32F407VE/Sha256Process.cpp), remove for the
+   portable C one of mbedtls */
+#define MBEDTLS_SHA256_PROCESS_ALT
+/* Only Ed25519 hashes with SHA-512 */
+#if (ED25519_FIRMWARE_VALIDATION == 1)
+#define MBEDTLS_SHA512_C
+#endif
 
 #define MBEDTLS_RSA_C
 #define MBEDTLS_BIGNUM_C
@@ -17,29 +26,29 @@
 #define MBEDTLS_PKCS1_V21
 #define MBEDTLS_MD_C
 
-#define MBEDTLS_PK_C
-#define MBEDTLS_PK_PARSE_C
 #define MBEDTLS_ASN1_PARSE_C
 
-#define MBEDTLS_X509_USE_C
-#define MBEDTLS_X509_CRT_PARSE_C
-
-#define MBEDTLS_PEM_PARSE_C
-#define MBEDTLS_BASE64_C
-
 #define MBEDTLS_ECP_C
 #define MBEDTLS_ECDSA_C
 #define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+/* ECDSA verify speed. The fast reduction modulo the NIST prime costs flash only. The comb table of the
+   generator comes precomputed from flash with MBEDTLS_ECP_FIXED_POINT_OPTIM, without it the table is
+   built on the heap for every verify. The table of the public key is built on the heap for every verify
+   with a window of min(4, MBEDTLS_ECP_WINDOW_SIZE) for P-256, mbedtls never goes wider for a 256-bit
+   curve. So 4 is the fastest window, 5 to 7 change nothing, 2 and 3 trade speed for heap.
+   `make sweep` in tools/kernel_bench reports cycles and heap of every setting, both can be passed
+   on the command line. */
+#define MBEDTLS_ECP_NIST_OPTIM
+#ifndef MBEDTLS_ECP_WINDOW_SIZE
+#define MBEDTLS_ECP_WINDOW_SIZE 4
+#endif
+#ifndef MBEDTLS_ECP_FIXED_POINT_OPTIM
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM 1
+#endif
 #define MBEDTLS_ECDH_C
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_OID_C
 #define MBEDTLS_ASN1_PARSE_C
 #define MBEDTLS_ASN1_WRITE_C
-#define MBEDTLS_PK_PARSE_C
-#define MBEDTLS_PK_WRITE_C
-#define MBEDTLS_X509_CREATE_C
-#define MBEDTLS_X509_CRT_PARSE_C
-#define MBEDTLS_PEM_PARSE_C
-#define MBEDTLS_PEM_WRITE_C
 
 #endif /* BOOT_MBEDTLS_CONFIG_H */
@@ -11,6 +11,7 @@ class AppJumper
         uint32_t appStartAddress = metaData->appStartAddress;
 
         DisableInterrupts();
+        ResetPeripherals();
         SetVectorTableAddress(appStartAddress);
         SetMainStackPointer(appStartAddress);
         JumpToResetHandler(appStartAddress);
@@ -37,6 +38,12 @@ class AppJumper
         SCB->SHCSR &= ~(SCB_SHCSR_USGFAULTENA_Msk | SCB_SHCSR_BUSFAULTENA_Msk | SCB_SHCSR_MEMFAULTENA_Msk);
     }
 
+    void ResetPeripherals() const
+    {
+        /* Stops the circular reception DMA, which would otherwise keep writing into the application's RAM */
+        HAL_DeInit();
+    }
+
     void SetVectorTableAddress(uint32_t address) const
     {
         SCB->VTOR = address;
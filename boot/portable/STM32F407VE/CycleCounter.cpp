@@ -0,0 +1,13 @@
+#include "CycleCounter.h"
+
+CycleCounter::CycleCounter()
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    start = DWT->CYCCNT;
+}
+
+uint32_t CycleCounter::Elapsed() const
+{
+    return DWT->CYCCNT - start;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "stm32f4xx_hal.h"
+
+/* Core clock cycles through the DWT cycle counter, for measuring the cost of a code path on the target.
+   The 32-bit counter wraps after about 25 s at 168 MHz. */
+class CycleCounter
+{
+  public:
+    CycleCounter();
+
+    uint32_t Elapsed() const;
+
+  private:
+    uint32_t start;
+};
@@ -0,0 +1,132 @@
+#include "FlashKernels.h"
+#include <cstring>
+
+namespace {
+constexpr uint32_t erasedWord = 0xFFFFFFFFU;
+constexpr size_t blockSize = 4U * sizeof(uint32_t);
+
+uint32_t LoadWord(const uint8_t* data)
+{
+    uint32_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+size_t HeadSize(const uint8_t* flash, size_t size)
+{
+    size_t misalignment = reinterpret_cast<uintptr_t>(flash) & (sizeof(uint32_t) - 1U);
+    size_t head = (misalignment == 0U) ? 0U : sizeof(uint32_t) - misalignment;
+
+    return (head < size) ? head : size;
+}
+} // namespace
+
+bool FlashKernels::IsErased(const uint8_t* flash, size_t size)
+{
+    size_t offset = HeadSize(flash, size);
+
+    for (size_t i = 0U; i < offset; ++i)
+    {
+        if (flash[i] != 0xFFU)
+        {
+            return false;
+        }
+    }
+
+    /* AND of four words, a single compare per block */
+    for (; size - offset >= blockSize; offset += blockSize)
+    {
+        const uint32_t* word = reinterpret_cast<const uint32_t*>(&flash[offset]);
+        if ((word[0] & word[1] & word[2] & word[3]) != erasedWord)
+        {
+            return false;
+        }
+    }
+
+    for (; offset < size; ++offset)
+    {
+        if (flash[offset] != 0xFFU)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FlashKernels::IsFilled(const uint8_t* flash, uint8_t pattern, size_t size)
+{
+    uint32_t patternWord = pattern * 0x01010101U;
+    size_t offset = HeadSize(flash, size);
+
+    for (size_t i = 0U; i < offset; ++i)
+    {
+        if (flash[i] != pattern)
+        {
+            return false;
+        }
+    }
+
+    /* OR of the XORed words, as for FirstDifference */
+    for (; size - offset >= blockSize; offset += blockSize)
+    {
+        const uint32_t* word = reinterpret_cast<const uint32_t*>(&flash[offset]);
+        if (((word[0] ^ patternWord) | (word[1] ^ patternWord) | (word[2] ^ patternWord) | (word[3] ^ patternWord))
+            != 0U)
+        {
+            return false;
+        }
+    }
+
+    for (; offset < size; ++offset)
+    {
+        if (flash[offset] != pattern)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t FlashKernels::FirstDifference(const uint8_t* flash, const uint8_t* buffer, size_t size)
+{
+    size_t offset = HeadSize(flash, size);
+
+    for (size_t i = 0U; i < offset; ++i)
+    {
+        if (flash[i] != buffer[i])
+        {
+            return i;
+        }
+    }
+
+    /* OR of the XORed words, the block is searched byte by byte only once it differs */
+    for (; size - offset >= blockSize; offset += blockSize)
+    {
+        const uint32_t* word = reinterpret_cast<const uint32_t*>(&flash[offset]);
+        const uint8_t* source = &buffer[offset];
+        uint32_t difference = (word[0] ^ LoadWord(source)) | (word[1] ^ LoadWord(source + 4U))
+            | (word[2] ^ LoadWord(source + 8U)) | (word[3] ^ LoadWord(source + 12U));
+
+        if (difference != 0U)
+        {
+            break;
+        }
+    }
+
+    for (; offset < size; ++offset)
+    {
+        if (flash[offset] != buffer[offset])
+        {
+            return offset;
+        }
+    }
+
+    return size;
+}
+
+bool FlashKernels::Equals(const uint8_t* flash, const uint8_t* buffer, size_t size)
+{
+    return FirstDifference(flash, buffer, size) == size;
+}
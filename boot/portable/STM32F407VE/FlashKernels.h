@@ -0,0 +1,15 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/* Word-wide scans of flash contents. Bytes up to the first word boundary of the flash side and the
+   tail are checked one by one, everything in between four words per iteration. The buffer side may
+   be unaligned. */
+namespace FlashKernels {
+bool IsErased(const uint8_t* flash, size_t size);
+/* Every byte equals pattern */
+bool IsFilled(const uint8_t* flash, uint8_t pattern, size_t size);
+bool Equals(const uint8_t* flash, const uint8_t* buffer, size_t size);
+/* Offset of the first byte that differs, size if the ranges are equal */
+size_t FirstDifference(const uint8_t* flash, const uint8_t* buffer, size_t size);
+} // namespace FlashKernels
@@ -1,5 +1,7 @@
 #include "FlashManager.h"
+#include "FlashKernels.h"
 #include "stm32f4xx_hal.h"
+#include <algorithm>
 #include <cstring>
 
 namespace FlashConstants {
@@ -18,10 +20,19 @@ constexpr uint32_t sectorAddresses[][2] = {
     {0x080E0000U, 0x080FFFFFU}};
 constexpr uint32_t sectorCount = sizeof(sectorAddresses) / sizeof(sectorAddresses[0]);
 constexpr uint32_t sectorNotFound = 0xFFFFFFFFU;
+/* Worst case for a 128 KB sector is 2 s at 2.7-3.6 V */
+constexpr uint32_t eraseTimeoutMs = 5000U;
+constexpr uint32_t programTimeoutMs = 50U;
 } // namespace FlashConstants
 
 FlashManager::RetStatus FlashManager::ToggleFlashLock(bool lock)
 {
+    /* Between Unlock() and Lock() the flash stays unlocked across operations */
+    if (lock && sessionUnlocked_)
+    {
+        return RetStatus::eOk;
+    }
+
     auto operation = lock ? HAL_FLASH_Lock : HAL_FLASH_Unlock;
     return (operation() == HAL_OK) ? RetStatus::eOk : RetStatus::eNotOk;
 }
@@ -52,7 +63,58 @@ constexpr FlashManager::sectorRange FlashManager::GetSectorRange(uint32_t startA
     return range;
 }
 
-FlashManager::RetStatus FlashManager::Erase(uint32_t startAddress, uint32_t endAddress)
+bool FlashManager::IsSectorBlank(uint32_t sector)
+{
+    uint32_t startAddress = FlashConstants::sectorAddresses[sector][0];
+    uint32_t size = FlashConstants::sectorAddresses[sector][1] - startAddress + 1U;
+
+    return FlashKernels::IsErased(reinterpret_cast<const uint8_t*>(startAddress), size);
+}
+
+FlashManager::RetStatus FlashManager::StartSectorErase(uint32_t sector)
+{
+    uint32_t sectorMask = 1UL << sector;
+
+    /* Stale error flags would make the HAL reject the erase as well */
+    if ((ToggleFlashLock(false) != RetStatus::eOk)
+        || (FLASH_WaitForLastOperation(FlashConstants::eraseTimeoutMs) != HAL_OK))
+    {
+        ToggleFlashLock(true);
+        failedSectors_ |= sectorMask;
+        return RetStatus::eNotOk;
+    }
+
+    pendingSectors_ &= ~sectorMask;
+    activeSector_ = sector;
+    FLASH_Erase_Sector(sector, FLASH_VOLTAGE_RANGE_3);
+
+    return RetStatus::eOk;
+}
+
+FlashManager::RetStatus FlashManager::FinishSectorErase()
+{
+    uint32_t sectorMask = 1UL << activeSector_;
+    HAL_StatusTypeDef status = FLASH_WaitForLastOperation(FlashConstants::eraseTimeoutMs);
+
+    CLEAR_BIT(FLASH->CR, (FLASH_CR_SER | FLASH_CR_SNB));
+    /* The caches may still hold lines of the old sector contents */
+    FLASH_FlushCaches();
+    ToggleFlashLock(true);
+    activeSector_ = noSector;
+
+    if (status != HAL_OK)
+    {
+        /* Not retried in the background, the next Write to the sector retries and reports it */
+        pendingSectors_ |= sectorMask;
+        failedSectors_ |= sectorMask;
+        return RetStatus::eNotOk;
+    }
+
+    failedSectors_ &= ~sectorMask;
+    return RetStatus::eOk;
+}
+
+FlashManager::RetStatus FlashManager::ScheduleErase(uint32_t startAddress, uint32_t endAddress)
 {
     auto range = GetSectorRange(startAddress, endAddress);
     if ((range.startSector == FlashConstants::sectorNotFound) || (range.sectorCount == 0U))
@@ -60,73 +122,306 @@ FlashManager::RetStatus FlashManager::Erase(uint32_t startAddress, uint32_t endA
         return RetStatus::einvalidSector;
     }
 
-    FLASH_EraseInitTypeDef eraseData = {
-        .TypeErase = FLASH_TYPEERASE_SECTORS,
-        .Banks = FLASH_BANK_1,
-        .Sector = range.startSector,
-        .NbSectors = range.sectorCount,
-        .VoltageRange = FLASH_VOLTAGE_RANGE_3};
-
-    if (ToggleFlashLock(false) != RetStatus::eOk)
+    if (activeSector_ != noSector)
     {
-        return RetStatus::eNotOk;
+        FinishSectorErase();
     }
 
-    uint32_t sectorError = FlashConstants::sectorNotFound;
-    auto status = HAL_FLASHEx_Erase(&eraseData, &sectorError);
-    ToggleFlashLock(true);
+    for (uint32_t sector = range.startSector; sector < range.startSector + range.sectorCount; ++sector)
+    {
+        /* Reading a whole sector takes well under a millisecond, erasing it up to two seconds */
+        if (!IsSectorBlank(sector))
+        {
+            pendingSectors_ |= 1UL << sector;
+        }
+    }
 
-    return (status == HAL_OK) ? RetStatus::eOk : RetStatus::eNotOk;
+    return RetStatus::eOk;
 }
 
-FlashManager::RetStatus FlashManager::Write(uint32_t startAddress, const void* data, size_t size)
+void FlashManager::ProcessErase()
 {
-    const uint8_t* pData = static_cast<const uint8_t*>(data);
-    uint32_t currentAddress = startAddress;
+    if (activeSector_ != noSector)
+    {
+        if (__HAL_FLASH_GET_FLAG(FLASH_FLAG_BSY) == RESET)
+        {
+            FinishSectorErase();
+        }
+        return;
+    }
 
-    if (ToggleFlashLock(false) != RetStatus::eOk)
+    /* Lowest sector first, that is the order the image is written in */
+    uint32_t candidates = pendingSectors_ & ~failedSectors_;
+
+    for (uint32_t sector = 0U; sector < FlashConstants::sectorCount; ++sector)
     {
-        return RetStatus::eNotOk;
+        if ((candidates & (1UL << sector)) != 0U)
+        {
+            StartSectorErase(sector);
+            return;
+        }
     }
+}
 
-    while (size > 0)
+FlashManager::RetStatus FlashManager::CompleteErase(uint32_t startAddress, uint32_t endAddress)
+{
+    auto range = GetSectorRange(startAddress, endAddress);
+    if ((range.startSector == FlashConstants::sectorNotFound) || (range.sectorCount == 0U))
     {
-        uint8_t programType;
-        uint64_t programData;
-        size_t increment;
+        return RetStatus::einvalidSector;
+    }
 
-        if (size >= 4)
+    /* Only one flash operation at a time, a failure elsewhere stays pending and does not matter here */
+    if (activeSector_ != noSector)
+    {
+        FinishSectorErase();
+    }
+
+    RetStatus status = RetStatus::eOk;
+    uint32_t endSector = range.startSector + range.sectorCount;
+
+    for (uint32_t sector = range.startSector; (sector < endSector) && (status == RetStatus::eOk); ++sector)
+    {
+        if ((pendingSectors_ & (1UL << sector)) != 0U)
         {
-            programType = FLASH_TYPEPROGRAM_WORD;
-            programData = *reinterpret_cast<const uint32_t*>(pData);
-            increment = 4;
+            status = StartSectorErase(sector);
+            if (status == RetStatus::eOk)
+            {
+                status = FinishSectorErase();
+            }
         }
-        else if (size >= 2)
+    }
+
+    return status;
+}
+
+FlashManager::RetStatus FlashManager::Erase(uint32_t startAddress, uint32_t endAddress)
+{
+    RetStatus status = ScheduleErase(startAddress, endAddress);
+
+    return (status == RetStatus::eOk) ? CompleteErase(startAddress, endAddress) : status;
+}
+
+HAL_StatusTypeDef FlashManager::ProgramWords(uint32_t address, const uint8_t* data, size_t wordCount,
+                                             size_t sourceStep)
+{
+    HAL_StatusTypeDef status = FLASH_WaitForLastOperation(FlashConstants::programTimeoutMs);
+    if (status != HAL_OK)
+    {
+        return status;
+    }
+
+    /* PSIZE and PG are set once for the whole burst, HAL_FLASH_Program does it again for every word */
+    MODIFY_REG(FLASH->CR, FLASH_CR_PSIZE, FLASH_PSIZE_WORD);
+    SET_BIT(FLASH->CR, FLASH_CR_PG);
+
+    volatile uint32_t* destination = reinterpret_cast<volatile uint32_t*>(address);
+
+    for (size_t i = 0U; (i < wordCount) && (status == HAL_OK); ++i)
+    {
+        uint32_t word;
+        std::memcpy(&word, data, sizeof(word));
+        data += sourceStep;
+
+        /* Words already holding the value, 0xFFFFFFFF in erased flash above all, are not programmed */
+        if (destination[i] == word)
         {
-            programType = FLASH_TYPEPROGRAM_HALFWORD;
-            programData = *reinterpret_cast<const uint16_t*>(pData);
-            increment = 2;
+            continue;
         }
-        else
+
+        destination[i] = word;
+
+        /* The error flags are sticky, only BSY is polled per word and the errors once after the burst.
+           Bounded like FLASH_WaitForLastOperation, a stuck controller must not hang the bootloader. */
+        uint32_t tickStart = HAL_GetTick();
+        while ((__HAL_FLASH_GET_FLAG(FLASH_FLAG_BSY) != RESET) && (status == HAL_OK))
         {
-            programType = FLASH_TYPEPROGRAM_BYTE;
-            programData = *pData;
-            increment = 1;
+            if (HAL_GetTick() - tickStart > FlashConstants::programTimeoutMs)
+            {
+                status = HAL_TIMEOUT;
+            }
         }
+    }
+
+    if (status == HAL_OK)
+    {
+        status = FLASH_WaitForLastOperation(FlashConstants::programTimeoutMs);
+    }
+    CLEAR_BIT(FLASH->CR, FLASH_CR_PG);
+
+    return status;
+}
+
+FlashManager::RetStatus FlashManager::Write(uint32_t startAddress, const void* data, size_t size)
+{
+    const uint8_t* pData = static_cast<const uint8_t*>(data);
+    uint32_t currentAddress = startAddress;
+    uint32_t endAddress = startAddress + size;
+    HAL_StatusTypeDef status = HAL_OK;
 
-        if (HAL_FLASH_Program(programType, currentAddress, programData) != HAL_OK)
+    if ((size > 0U) && (CompleteErase(startAddress, endAddress - 1U) != RetStatus::eOk))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    if (ToggleFlashLock(false) != RetStatus::eOk)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    /* Bytes up to the first word boundary, one burst of whole words, then the remaining bytes */
+    while ((status == HAL_OK) && (currentAddress < endAddress) && ((currentAddress & 0x3U) != 0U))
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, currentAddress++, *pData++);
+    }
+
+    size_t wordCount = (endAddress - currentAddress) / sizeof(uint32_t);
+
+    if ((status == HAL_OK) && (wordCount > 0U))
+    {
+        status = ProgramWords(currentAddress, pData, wordCount, sizeof(uint32_t));
+        currentAddress += wordCount * sizeof(uint32_t);
+        pData += wordCount * sizeof(uint32_t);
+    }
+
+    while ((status == HAL_OK) && (currentAddress < endAddress))
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, currentAddress++, *pData++);
+    }
+
+    ToggleFlashLock(true);
+
+    /* Read back against the source, flash that was not erased keeps bits the data would set */
+    bool written = (status == HAL_OK)
+        && FlashKernels::Equals(reinterpret_cast<const uint8_t*>(startAddress), static_cast<const uint8_t*>(data),
+                                size);
+
+    return written ? RetStatus::eOk : RetStatus::eNotOk;
+}
+
+FlashManager::RetStatus FlashManager::CommitStaging(bool all)
+{
+    /* A partial word at the end stays staged unless everything has to go out */
+    uint32_t stagingEnd = stagingAddress_ + stagingLength_;
+    uint32_t commitEnd = all ? stagingEnd : (stagingEnd & ~0x3U);
+    size_t commitLength = commitEnd - stagingAddress_;
+
+    RetStatus status = Write(stagingAddress_, staging_.data(), commitLength);
+
+    /* The packet that owned the data has been acknowledged already, the failure has to stick until the
+       session is discarded, so Flush() at validation still reports it */
+    if (status != RetStatus::eOk)
+    {
+        stagingFailed_ = true;
+    }
+
+    std::memmove(staging_.data(), &staging_[commitLength], stagingEnd - commitEnd);
+    stagingAddress_ = commitEnd;
+    stagingLength_ = stagingEnd - commitEnd;
+
+    return status;
+}
+
+FlashManager::RetStatus FlashManager::BufferedWrite(uint32_t startAddress, const void* data, size_t size)
+{
+    const uint8_t* pData = static_cast<const uint8_t*>(data);
+    RetStatus status = stagingFailed_ ? RetStatus::eNotOk : RetStatus::eOk;
+
+    /* Only a write continuing the staged data is merged */
+    if ((status == RetStatus::eOk) && (stagingLength_ > 0U) && (startAddress != stagingAddress_ + stagingLength_))
+    {
+        status = Flush();
+    }
+
+    if (stagingLength_ == 0U)
+    {
+        stagingAddress_ = startAddress;
+    }
+
+    while ((status == RetStatus::eOk) && (size > 0U))
+    {
+        size_t chunk = std::min(size, stagingSize - stagingLength_);
+
+        std::memcpy(&staging_[stagingLength_], pData, chunk);
+        stagingLength_ += chunk;
+        pData += chunk;
+        size -= chunk;
+
+        if (stagingLength_ == stagingSize)
         {
-            ToggleFlashLock(true);
-            return RetStatus::eNotOk;
+            status = CommitStaging(false);
         }
+    }
 
-        currentAddress += increment;
-        pData += increment;
-        size -= increment;
+    return status;
+}
+
+FlashManager::RetStatus FlashManager::Flush()
+{
+    RetStatus status = (stagingLength_ > 0U) ? CommitStaging(true) : RetStatus::eOk;
+
+    return stagingFailed_ ? RetStatus::eNotOk : status;
+}
+
+void FlashManager::Discard()
+{
+    stagingLength_ = 0U;
+    stagingFailed_ = false;
+}
+
+FlashManager::RetStatus FlashManager::Fill(uint32_t startAddress, uint8_t pattern, size_t size)
+{
+    /* Nothing to program for 0xFF, but the callers record the range as erased, so it has to be */
+    if (pattern == 0xFFU)
+    {
+        bool erased = (size == 0U)
+            || ((CompleteErase(startAddress, startAddress + size - 1U) == RetStatus::eOk)
+                && FlashKernels::IsErased(reinterpret_cast<const uint8_t*>(startAddress), size));
+
+        return erased ? RetStatus::eOk : RetStatus::eNotOk;
+    }
+
+    uint32_t currentAddress = startAddress;
+    uint32_t endAddress = startAddress + size;
+    uint32_t patternWord = pattern * 0x01010101U;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if ((size > 0U) && (CompleteErase(startAddress, endAddress - 1U) != RetStatus::eOk))
+    {
+        return RetStatus::eNotOk;
+    }
+
+    if (ToggleFlashLock(false) != RetStatus::eOk)
+    {
+        return RetStatus::eNotOk;
+    }
+
+    /* Bytes up to the first word boundary, whole words, then the remaining bytes */
+    while ((status == HAL_OK) && (currentAddress < endAddress) && ((currentAddress & 0x3U) != 0U))
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, currentAddress++, pattern);
+    }
+
+    size_t wordCount = (endAddress - currentAddress) / sizeof(uint32_t);
+
+    if ((status == HAL_OK) && (wordCount > 0U))
+    {
+        status = ProgramWords(currentAddress, reinterpret_cast<const uint8_t*>(&patternWord), wordCount, 0U);
+        currentAddress += wordCount * sizeof(uint32_t);
+    }
+
+    while ((status == HAL_OK) && (currentAddress < endAddress))
+    {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE, currentAddress++, pattern);
     }
 
     ToggleFlashLock(true);
-    return RetStatus::eOk;
+
+    /* Read back as in Write, the callers record the range as filled */
+    bool filled =
+        (status == HAL_OK) && FlashKernels::IsFilled(reinterpret_cast<const uint8_t*>(startAddress), pattern, size);
+
+    return filled ? RetStatus::eOk : RetStatus::eNotOk;
 }
 
 FlashManager::RetStatus FlashManager::Read(uint32_t startAddress, void* buffer, size_t size)
@@ -136,12 +431,28 @@ FlashManager::RetStatus FlashManager::Read(uint32_t startAddress, void* buffer,
     return RetStatus::eOk;
 }
 
+FlashManager::RetStatus FlashManager::GetSectorInfo(uint32_t address, sectorInfo& info)
+{
+    for (uint32_t i = 0U; i < FlashConstants::sectorCount; ++i)
+    {
+        if ((address >= FlashConstants::sectorAddresses[i][0]) && (address <= FlashConstants::sectorAddresses[i][1]))
+        {
+            info = {i, FlashConstants::sectorAddresses[i][0], FlashConstants::sectorAddresses[i][1]};
+            return RetStatus::eOk;
+        }
+    }
+
+    return RetStatus::einvalidSector;
+}
+
 FlashManager::RetStatus FlashManager::Unlock()
 {
+    sessionUnlocked_ = true;
     return ToggleFlashLock(false);
 }
 
 FlashManager::RetStatus FlashManager::Lock()
 {
+    sessionUnlocked_ = false;
     return ToggleFlashLock(true);
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include "FlashMapping.h"
 
 class FlashManager
@@ -19,13 +20,52 @@ class FlashManager
         uint32_t sectorCount;
     };
 
+    struct sectorInfo
+    {
+        uint32_t index;
+        uint32_t startAddress;
+        uint32_t endAddress;
+    };
+
     RetStatus Erase(uint32_t startAddress, uint32_t endAddress);
+    /* Background erase: ScheduleErase only records the sectors, ProcessErase erases them one by one
+       from the main loop and Write/Fill complete the sectors they program on demand */
+    RetStatus ScheduleErase(uint32_t startAddress, uint32_t endAddress);
+    void ProcessErase();
+    RetStatus CompleteErase(uint32_t startAddress, uint32_t endAddress);
     RetStatus Write(uint32_t startAddress, const void* data, size_t size);
+    RetStatus Fill(uint32_t startAddress, uint8_t pattern, size_t size);
+    /* Write-combining: adjacent writes are collected and programmed as whole aligned words. Nothing
+       written this way is in flash before Flush(), errors show up on a later call. A failed commit
+       sticks: BufferedWrite and Flush report it until Discard(). */
+    RetStatus BufferedWrite(uint32_t startAddress, const void* data, size_t size);
+    RetStatus Flush();
+    void Discard();
     RetStatus Read(uint32_t startAddress, void* buffer, size_t size);
+    RetStatus GetSectorInfo(uint32_t address, sectorInfo& info);
+    /* Keeps the flash unlocked until Lock(), instead of unlocking and locking around every operation */
     RetStatus Unlock();
     RetStatus Lock();
 
   private:
+    static constexpr uint32_t noSector = 0xFFFFFFFFU;
+    static constexpr size_t stagingSize = 256U;
+
+    std::array<uint8_t, stagingSize> staging_;
+    uint32_t stagingAddress_{0U};
+    size_t stagingLength_{0U};
+    bool stagingFailed_{false};
+
+    uint32_t pendingSectors_{0U};
+    uint32_t failedSectors_{0U};
+    uint32_t activeSector_{noSector};
+    bool sessionUnlocked_{false};
+
     static constexpr sectorRange GetSectorRange(uint32_t startAddress, uint32_t endAddress);
     RetStatus ToggleFlashLock(bool lock);
+    bool IsSectorBlank(uint32_t sector);
+    RetStatus StartSectorErase(uint32_t sector);
+    RetStatus FinishSectorErase();
+    RetStatus CommitStaging(bool all);
+    HAL_StatusTypeDef ProgramWords(uint32_t address, const uint8_t* data, size_t wordCount, size_t sourceStep);
 };
@@ -9,10 +9,41 @@ static constexpr uint32_t appMetaDataAddress = 0x0800C000U;
 static constexpr uint32_t appSignatureMaxSize = 256U;
 static constexpr uint32_t maxDataSize = 16u;
 
+/* Last sector, delta updates rebuild every sector here before it replaces the original. An
+   application that reaches into it can only be updated with a full image. */
+static constexpr uint32_t deltaScratchAddress = 0x080E0000U;
+
 constexpr uint32_t bootFlagValue = 0xA5A5A5A5U;
 static volatile uint32_t noInitBootFlag __attribute__((section(".no_init_ram"))) = 0U;
 static constexpr uint32_t noInitSectionSize = 8U;
 
+/* One-time programmable area, 16 blocks of 32 bytes. Block i can no longer be programmed once lock
+   byte i is 0x00. */
+static constexpr uint32_t otpBaseAddress = 0x1FFF7800U;
+static constexpr uint32_t otpLockAddress = 0x1FFF7A00U;
+static constexpr uint32_t otpBlockCount = 16U;
+static constexpr uint32_t otpBlockSize = 32U;
+
+/* Written by the bootloader after a full signature check, see FAST_BOOT_VALIDATION */
+struct ValidationRecord
+{
+    uint32_t marker;
+    uint32_t imageCrc;
+    uint8_t mac[32];
+} __attribute__((__packed__));
+
+/* Root of the signed Merkle manifest, written once its signature is checked, see MerkleManifest.
+   With a manifest the signature covers the root instead of the image digest. */
+struct ManifestHeader
+{
+    uint32_t marker;
+    uint32_t startAddress;
+    uint32_t endAddress;
+    uint8_t blockSizeLog2;
+    uint8_t notUsed[3];
+    uint8_t root[32];
+} __attribute__((__packed__));
+
 struct MetaData
 {
     uint16_t signatureSize;
@@ -21,6 +52,8 @@ struct MetaData
     uint32_t appStartAddress;
     uint32_t appEndAddress;
     uint32_t appPresentFlag;
+    ValidationRecord validationRecord;
+    ManifestHeader manifest;
 } __attribute__((__packed__));
 
 inline MetaData* GetMetaData()
@@ -42,4 +75,26 @@ inline size_t GetAppSize()
 constexpr uint32_t appSignatureSizeAddress = appMetaDataAddress + offsetof(MetaData, signatureSize);
 constexpr uint32_t appSignatureAddress = appMetaDataAddress + offsetof(MetaData, signature);
 constexpr uint32_t appValidFlagAddress = appMetaDataAddress + offsetof(MetaData, appPresentFlag);
+constexpr uint32_t appValidationRecordAddress = appMetaDataAddress + offsetof(MetaData, validationRecord);
+constexpr uint32_t appManifestAddress = appMetaDataAddress + offsetof(MetaData, manifest);
+
+/* The valid flag, the validation record and the manifest header are only ever written by the
+   bootloader itself, never with data from the host */
+inline bool IsBootloaderOwned(uint32_t address, size_t size)
+{
+    constexpr uint32_t ownedStart = appValidFlagAddress;
+    constexpr uint32_t ownedEnd = appMetaDataAddress + sizeof(MetaData);
+
+    return (size != 0U) && (address < ownedEnd) && ((address >= ownedStart) || (size > ownedStart - address));
+}
+
+inline const uint8_t* GetOtpBlock(uint32_t block)
+{
+    return reinterpret_cast<const uint8_t*>(otpBaseAddress + (block * otpBlockSize));
+}
+
+inline bool IsOtpBlockLocked(uint32_t block)
+{
+    return reinterpret_cast<const volatile uint8_t*>(otpLockAddress)[block] == 0x00U;
+}
 }; // namespace FlashMapping
@@ -0,0 +1,27 @@
+#include "HardwareCrc.h"
+#include <cstring>
+
+uint32_t HardwareCrc::Calculate(const uint8_t* data, size_t size)
+{
+    size_t wordCount = size / sizeof(uint32_t);
+    size_t tailSize = size % sizeof(uint32_t);
+
+    __HAL_RCC_CRC_CLK_ENABLE();
+    CRC->CR = CRC_CR_RESET;
+
+    for (size_t i = 0U; i < wordCount; ++i)
+    {
+        uint32_t word;
+        std::memcpy(&word, &data[i * sizeof(uint32_t)], sizeof(word));
+        CRC->DR = word;
+    }
+
+    if (tailSize != 0U)
+    {
+        uint32_t word = 0xFFFFFFFFU;
+        std::memcpy(&word, &data[wordCount * sizeof(uint32_t)], tailSize);
+        CRC->DR = word;
+    }
+
+    return CRC->DR;
+}
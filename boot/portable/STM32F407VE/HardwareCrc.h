@@ -0,0 +1,12 @@
+#pragma once
+#include "stm32f4xx_hal.h"
+#include <cstddef>
+
+/* CRC-32 through the CRC peripheral (polynomial 0x04C11DB7, initial value 0xFFFFFFFF, no reflection,
+   no final XOR). The unit takes whole words, so data is fed as little-endian words and a partial
+   last word is padded with 0xFF, the value erased flash would read. */
+class HardwareCrc
+{
+  public:
+    uint32_t Calculate(const uint8_t* data, size_t size);
+};
@@ -0,0 +1,131 @@
+extern "C"
+{
+#include "mbedtls/sha256.h"
+}
+
+/* SHA-256 compression for Cortex-M4, replaces the portable C one of mbedtls. The eight working
+   variables stay in registers and the variables are renamed instead of shifted. Rounds 0 to 15 are
+   written out and read the message words straight from the input (flash through the ART accelerator
+   during image hashing, mbedtls passes whole blocks without copying). Rounds 16 to 63 run as a loop of
+   three passes over a body of 16 written-out rounds, so every schedule index is still a constant.
+   tools/kernel_bench/sha256_bench.cpp checks it against FIPS 180-4 and mbedtls. */
+#if defined(MBEDTLS_SHA256_PROCESS_ALT)
+
+extern "C"
+{
+#include "mbedtls/platform_util.h"
+}
+#include "stm32f4xx_hal.h"
+#include <cstring>
+
+namespace {
+constexpr uint32_t roundConstants[64] = {
+    0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U, 0xAB1C5ED5U,
+    0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU, 0x9BDC06A7U, 0xC19BF174U,
+    0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU, 0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU,
+    0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U, 0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U,
+    0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU, 0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U,
+    0xA2BFE8A1U, 0xA81A664BU, 0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U,
+    0x19A4C116U, 0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+    0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U, 0xC67178F2U};
+
+constexpr size_t scheduleWords = 16U;
+
+__attribute__((always_inline)) inline uint32_t Rotr(uint32_t x, unsigned n)
+{
+    return (x >> n) | (x << (32U - n));
+}
+
+/* Message word i of the block, big-endian, the input may be unaligned */
+__attribute__((always_inline)) inline uint32_t Load(uint32_t* w, const unsigned char* data, size_t i)
+{
+    uint32_t word;
+
+    std::memcpy(&word, &data[i * sizeof(uint32_t)], sizeof(word));
+    w[i] = __REV(word);
+    return w[i];
+}
+
+/* Next schedule word in place of the one 16 rounds back */
+__attribute__((always_inline)) inline uint32_t Expand(uint32_t* w, size_t i)
+{
+    uint32_t w2 = w[(i + 14U) % scheduleWords];
+    uint32_t w15 = w[(i + 1U) % scheduleWords];
+
+    w[i] += (Rotr(w2, 17U) ^ Rotr(w2, 19U) ^ (w2 >> 10U)) + w[(i + 9U) % scheduleWords]
+            + (Rotr(w15, 7U) ^ Rotr(w15, 18U) ^ (w15 >> 3U));
+    return w[i];
+}
+
+/* One round with the variables renamed instead of shifted, only d and h change */
+__attribute__((always_inline)) inline void Round(uint32_t a, uint32_t b, uint32_t c, uint32_t& d, uint32_t e,
+                                                 uint32_t f, uint32_t g, uint32_t& h, uint32_t kw)
+{
+    uint32_t t1 = h + (Rotr(e, 6U) ^ Rotr(e, 11U) ^ Rotr(e, 25U)) + (g ^ (e & (f ^ g))) + kw;
+    uint32_t t2 = (Rotr(a, 2U) ^ Rotr(a, 13U) ^ Rotr(a, 22U)) + ((a & b) | (c & (a | b)));
+
+    d += t1;
+    h = t1 + t2;
+}
+} // namespace
+
+extern "C" int mbedtls_internal_sha256_process(mbedtls_sha256_context* ctx, const unsigned char data[64])
+{
+    uint32_t* state = ctx->MBEDTLS_PRIVATE(state);
+    uint32_t w[scheduleWords];
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+    Round(a, b, c, d, e, f, g, h, roundConstants[0] + Load(w, data, 0U));
+    Round(h, a, b, c, d, e, f, g, roundConstants[1] + Load(w, data, 1U));
+    Round(g, h, a, b, c, d, e, f, roundConstants[2] + Load(w, data, 2U));
+    Round(f, g, h, a, b, c, d, e, roundConstants[3] + Load(w, data, 3U));
+    Round(e, f, g, h, a, b, c, d, roundConstants[4] + Load(w, data, 4U));
+    Round(d, e, f, g, h, a, b, c, roundConstants[5] + Load(w, data, 5U));
+    Round(c, d, e, f, g, h, a, b, roundConstants[6] + Load(w, data, 6U));
+    Round(b, c, d, e, f, g, h, a, roundConstants[7] + Load(w, data, 7U));
+    Round(a, b, c, d, e, f, g, h, roundConstants[8] + Load(w, data, 8U));
+    Round(h, a, b, c, d, e, f, g, roundConstants[9] + Load(w, data, 9U));
+    Round(g, h, a, b, c, d, e, f, roundConstants[10] + Load(w, data, 10U));
+    Round(f, g, h, a, b, c, d, e, roundConstants[11] + Load(w, data, 11U));
+    Round(e, f, g, h, a, b, c, d, roundConstants[12] + Load(w, data, 12U));
+    Round(d, e, f, g, h, a, b, c, roundConstants[13] + Load(w, data, 13U));
+    Round(c, d, e, f, g, h, a, b, roundConstants[14] + Load(w, data, 14U));
+    Round(b, c, d, e, f, g, h, a, roundConstants[15] + Load(w, data, 15U));
+
+    /* Rounds 16 to 63 in three passes, the schedule position repeats every 16 rounds */
+    for (const uint32_t* k = &roundConstants[16]; k < &roundConstants[64]; k += scheduleWords)
+    {
+        Round(a, b, c, d, e, f, g, h, k[0] + Expand(w, 0U));
+        Round(h, a, b, c, d, e, f, g, k[1] + Expand(w, 1U));
+        Round(g, h, a, b, c, d, e, f, k[2] + Expand(w, 2U));
+        Round(f, g, h, a, b, c, d, e, k[3] + Expand(w, 3U));
+        Round(e, f, g, h, a, b, c, d, k[4] + Expand(w, 4U));
+        Round(d, e, f, g, h, a, b, c, k[5] + Expand(w, 5U));
+        Round(c, d, e, f, g, h, a, b, k[6] + Expand(w, 6U));
+        Round(b, c, d, e, f, g, h, a, k[7] + Expand(w, 7U));
+        Round(a, b, c, d, e, f, g, h, k[8] + Expand(w, 8U));
+        Round(h, a, b, c, d, e, f, g, k[9] + Expand(w, 9U));
+        Round(g, h, a, b, c, d, e, f, k[10] + Expand(w, 10U));
+        Round(f, g, h, a, b, c, d, e, k[11] + Expand(w, 11U));
+        Round(e, f, g, h, a, b, c, d, k[12] + Expand(w, 12U));
+        Round(d, e, f, g, h, a, b, c, k[13] + Expand(w, 13U));
+        Round(c, d, e, f, g, h, a, b, k[14] + Expand(w, 14U));
+        Round(b, c, d, e, f, g, h, a, k[15] + Expand(w, 15U));
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+
+    /* The HMAC of the validation record runs through here with the key */
+    mbedtls_platform_zeroize(w, sizeof(w));
+    return 0;
+}
+
+#endif /* MBEDTLS_SHA256_PROCESS_ALT */
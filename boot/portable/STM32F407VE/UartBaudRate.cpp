@@ -0,0 +1,54 @@
+#include "UartBaudRate.h"
+
+UartBaudRate::UartBaudRate(UART_HandleTypeDef& huart) : huart_(huart) {}
+
+uint32_t UartBaudRate::PeripheralClock() const
+{
+    /* USART1 and USART6 sit on APB2, the rest on APB1 */
+    if ((huart_.Instance == USART1) || (huart_.Instance == USART6))
+    {
+        return HAL_RCC_GetPCLK2Freq();
+    }
+
+    return HAL_RCC_GetPCLK1Freq();
+}
+
+uint32_t UartBaudRate::Resolve(uint32_t requested) const
+{
+    uint32_t clock = PeripheralClock();
+    uint32_t maxRate = clock / 16U;
+
+    if (requested == 0U)
+    {
+        return maxRate;
+    }
+
+    if (requested > maxRate)
+    {
+        return 0U;
+    }
+
+    /* The divider has a 4-bit fraction, so the generated rate is clock / round(clock / requested) */
+    uint32_t divider = (clock + (requested / 2U)) / requested;
+    uint32_t actual = clock / divider;
+    uint32_t error = (actual > requested) ? (actual - requested) : (requested - actual);
+
+    if ((static_cast<uint64_t>(error) * 1000U) > (static_cast<uint64_t>(requested) * maxErrorPermille))
+    {
+        return 0U;
+    }
+
+    return requested;
+}
+
+uint32_t UartBaudRate::Apply(uint32_t baudRate)
+{
+    uint32_t previous = huart_.Init.BaudRate;
+
+    __HAL_UART_DISABLE(&huart_);
+    huart_.Instance->BRR = UART_BRR_SAMPLING16(PeripheralClock(), baudRate);
+    huart_.Init.BaudRate = baudRate;
+    __HAL_UART_ENABLE(&huart_);
+
+    return previous;
+}
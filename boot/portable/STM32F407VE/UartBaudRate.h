@@ -0,0 +1,24 @@
+#pragma once
+#include "stm32f4xx_hal.h"
+
+/* Changes the baud rate of an initialized UART without restarting it, so DMA transfers and the
+   HAL state stay untouched. Only the 16x oversampling mode used by the bootloader is supported. */
+class UartBaudRate
+{
+  public:
+    explicit UartBaudRate(UART_HandleTypeDef& huart);
+
+    /* Returns the rate the link will run at, 0 requests the fastest one and 0 is returned when the
+       requested rate cannot be generated within tolerance from the peripheral clock */
+    uint32_t Resolve(uint32_t requested) const;
+
+    /* Returns the previous baud rate */
+    uint32_t Apply(uint32_t baudRate);
+
+  private:
+    static constexpr uint32_t maxErrorPermille = 20U;
+
+    UART_HandleTypeDef& huart_;
+
+    uint32_t PeripheralClock() const;
+};
@@ -0,0 +1,111 @@
+#include "UartDmaReceiver.h"
+#include <algorithm>
+#include <cstring>
+
+UartDmaReceiver::UartDmaReceiver(UART_HandleTypeDef& huart) : huart_(huart) {}
+
+bool UartDmaReceiver::Start()
+{
+    tail_ = 0U;
+    produced_ = 0U;
+    consumed_ = 0U;
+    overrun_ = false;
+    restartPending_ = false;
+    return HAL_UART_Receive_DMA(&huart_, buffer_, bufferSize) == HAL_OK;
+}
+
+void UartDmaReceiver::Stop()
+{
+    HAL_UART_DMAStop(&huart_);
+}
+
+void UartDmaReceiver::OnHalfTransfer()
+{
+    produced_ = produced_ + (bufferSize / 2U);
+
+    /* More produced than fits next to the unread data: the head has overwritten the tail */
+    if (produced_ - consumed_ > bufferSize)
+    {
+        overrun_ = true;
+    }
+}
+
+void UartDmaReceiver::OnError()
+{
+    restartPending_ = true;
+}
+
+uint32_t UartDmaReceiver::GetOverrunCount() const
+{
+    return overrunCount_;
+}
+
+bool UartDmaReceiver::Service()
+{
+    /* tail_ is only ever touched from the main loop, the interrupts just raise flags */
+    if (restartPending_)
+    {
+        Start();
+        return false;
+    }
+
+    if (overrun_)
+    {
+        /* Whatever is left is a mix of two laps, drop it and let the protocol retransmit */
+        __disable_irq();
+        size_t head = Head();
+        consumed_ = consumed_ + ((head - tail_) & (bufferSize - 1U));
+        tail_ = head;
+        overrun_ = false;
+        __enable_irq();
+        ++overrunCount_;
+    }
+
+    return true;
+}
+
+size_t UartDmaReceiver::Head() const
+{
+    /* NDTR counts down from bufferSize and is reloaded by the circular mode */
+    size_t head = (bufferSize - __HAL_DMA_GET_COUNTER(huart_.hdmarx)) & (bufferSize - 1U);
+
+    /* Bytes below the head must not be read before the counter itself */
+    __DMB();
+    return head;
+}
+
+size_t UartDmaReceiver::Available() const
+{
+    return (Head() - tail_) & (bufferSize - 1U);
+}
+
+bool UartDmaReceiver::Read(uint8_t* byte)
+{
+    if (!Service() || (tail_ == Head()))
+    {
+        return false;
+    }
+
+    *byte = buffer_[tail_];
+    tail_ = (tail_ + 1U) & (bufferSize - 1U);
+    consumed_ = consumed_ + 1U;
+    return true;
+}
+
+size_t UartDmaReceiver::Read(uint8_t* buffer, size_t size)
+{
+    if (!Service())
+    {
+        return 0U;
+    }
+
+    size_t count = std::min(size, Available());
+    size_t firstPart = std::min(count, bufferSize - tail_);
+
+    std::memcpy(buffer, &buffer_[tail_], firstPart);
+    std::memcpy(buffer + firstPart, buffer_, count - firstPart);
+    tail_ = (tail_ + count) & (bufferSize - 1U);
+    consumed_ = consumed_ + count;
+
+    return count;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "stm32f4xx_hal.h"
+#include <cstddef>
+#include "BootConfig.h"
+
+/* Single-producer/single-consumer ring fed by circular UART DMA. The DMA controller is the
+   producer and keeps storing bytes while the CPU is stalled by flash operations, the producer
+   index is derived from the stream's NDTR register so no interrupt is needed per byte. The
+   half and full transfer interrupts count the bytes produced, so a head lapping the tail is
+   detected and the unread data is dropped instead of being parsed as a mix of two laps. */
+class UartDmaReceiver
+{
+  public:
+    explicit UartDmaReceiver(UART_HandleTypeDef& huart);
+
+    bool Start();
+    void Stop();
+    bool Read(uint8_t* byte);
+    size_t Read(uint8_t* buffer, size_t size);
+    size_t Available() const;
+
+    /* Interrupt context: half or full transfer of the circular DMA */
+    void OnHalfTransfer();
+    /* Interrupt context: reception aborted, it is restarted by the next Read from the main loop */
+    void OnError();
+    /* Number of times unread data was overwritten since the start */
+    uint32_t GetOverrunCount() const;
+
+  private:
+    static constexpr size_t bufferSize = 16384U;
+    static_assert((bufferSize & (bufferSize - 1U)) == 0U, "Ring buffer size must be a power of two");
+
+    /* SOP, type, length and CRC16 around every payload */
+    static constexpr size_t frameOverhead = 6U;
+    static_assert(BootConfig::maxTransferWindowSize * (BootConfig::maxPacketPayloadSize + frameOverhead) <= bufferSize,
+                  "A full transfer window has to fit into the ring buffer");
+
+    UART_HandleTypeDef& huart_;
+    uint8_t buffer_[bufferSize];
+    size_t tail_{0U};
+    /* Totals since Start, the interrupt compares them to detect an overrun */
+    volatile uint32_t produced_{0U};
+    volatile uint32_t consumed_{0U};
+    volatile bool overrun_{false};
+    volatile bool restartPending_{false};
+    uint32_t overrunCount_{0U};
+
+    size_t Head() const;
+    bool Service();
+};
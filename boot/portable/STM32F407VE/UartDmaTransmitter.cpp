@@ -0,0 +1,124 @@
+#include "UartDmaTransmitter.h"
+#include <algorithm>
+#include <cstring>
+
+UartDmaTransmitter::UartDmaTransmitter(UART_HandleTypeDef& huart) : huart_(huart) {}
+
+bool UartDmaTransmitter::IsBootloaderFlash(const uint8_t* data, size_t size)
+{
+    uintptr_t address = reinterpret_cast<uintptr_t>(data);
+
+    /* Never erased or programmed while the bootloader runs */
+    return (address >= FLASH_BASE) && (address + size <= FlashMapping::appMinStartAddress);
+}
+
+void UartDmaTransmitter::Transmit(const uint8_t* data, size_t size)
+{
+    if (IsBootloaderFlash(data, size))
+    {
+        while (size > 0U)
+        {
+            uint16_t segmentSize = static_cast<uint16_t>(std::min(size, maxSegmentSize));
+            Enqueue(data, segmentSize, 0U);
+            data += segmentSize;
+            size -= segmentSize;
+        }
+        return;
+    }
+
+    while (size > 0U)
+    {
+        uint16_t poolUsed = 0U;
+        size_t segmentSize = std::min(size, poolSize / 2U);
+        uint8_t* copy = AllocatePool(segmentSize, poolUsed);
+
+        std::memcpy(copy, data, segmentSize);
+        Enqueue(copy, static_cast<uint16_t>(segmentSize), poolUsed);
+        data += segmentSize;
+        size -= segmentSize;
+    }
+}
+
+uint8_t* UartDmaTransmitter::AllocatePool(size_t size, uint16_t& poolUsed)
+{
+    size_t offset = poolHead_ % poolSize;
+    size_t contiguous = poolSize - offset;
+    /* Segments must be contiguous for the DMA, a chunk that does not fit skips the end of the pool */
+    size_t wasted = (size > contiguous) ? contiguous : 0U;
+
+    while (poolSize - (poolHead_ - poolTail_) < size + wasted)
+    {
+        /* Backpressure, wait for the DMA to release older segments */
+    }
+
+    poolUsed = static_cast<uint16_t>(size + wasted);
+    poolHead_ = poolHead_ + poolUsed;
+
+    return &pool_[(wasted != 0U) ? 0U : offset];
+}
+
+void UartDmaTransmitter::Enqueue(const uint8_t* data, uint16_t size, uint16_t poolUsed)
+{
+    while (queueHead_ - queueTail_ >= queueLength)
+    {
+        /* Backpressure, wait for a free queue entry */
+    }
+
+    queue_[queueHead_ % queueLength] = {data, size, poolUsed};
+    queueHead_ = queueHead_ + 1U;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (!busy_)
+    {
+        StartNext();
+    }
+    __set_PRIMASK(primask);
+}
+
+void UartDmaTransmitter::StartNext()
+{
+    /* A segment the DMA refuses is dropped rather than stalling the queue forever. The ones behind it
+       are still tried, the queue is never left with work pending and no transfer running. */
+    while (queueHead_ != queueTail_)
+    {
+        const Segment& segment = queue_[queueTail_ % queueLength];
+        busy_ = true;
+
+        if (HAL_UART_Transmit_DMA(&huart_, const_cast<uint8_t*>(segment.data), segment.size) == HAL_OK)
+        {
+            return;
+        }
+
+        poolTail_ = poolTail_ + segment.poolSize;
+        queueTail_ = queueTail_ + 1U;
+    }
+
+    busy_ = false;
+}
+
+void UartDmaTransmitter::OnTransferComplete()
+{
+    const Segment& segment = queue_[queueTail_ % queueLength];
+
+    poolTail_ = poolTail_ + segment.poolSize;
+    queueTail_ = queueTail_ + 1U;
+    StartNext();
+}
+
+bool UartDmaTransmitter::IsIdle() const
+{
+    return !busy_ && (queueHead_ == queueTail_);
+}
+
+void UartDmaTransmitter::Flush()
+{
+    while (!IsIdle())
+    {
+    }
+
+    /* Wait until the last stop bit has left the shift register */
+    while (__HAL_UART_GET_FLAG(&huart_, UART_FLAG_TC) == RESET)
+    {
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "stm32f4xx_hal.h"
+#include <cstddef>
+#include "FlashMapping.h"
+
+/* Asynchronous UART transmit queue drained by TX DMA. Data in the bootloader's own flash is queued by
+   reference, anything else is copied into a staging pool, so callers may reuse their buffers
+   immediately. The application region is copied as well, a flashStart right after the response may
+   erase it before the DMA gets there. The next segment is started from the transfer complete callback. */
+class UartDmaTransmitter
+{
+  public:
+    explicit UartDmaTransmitter(UART_HandleTypeDef& huart);
+
+    void Transmit(const uint8_t* data, size_t size);
+    void OnTransferComplete();
+    void Flush();
+    bool IsIdle() const;
+
+  private:
+    struct Segment
+    {
+        const uint8_t* data;
+        uint16_t size;
+        uint16_t poolSize;
+    };
+
+    static constexpr size_t queueLength = 16U;
+    static constexpr size_t poolSize = 2048U;
+    static constexpr size_t maxSegmentSize = 0xFFFFU;
+
+    UART_HandleTypeDef& huart_;
+    Segment queue_[queueLength];
+    uint8_t pool_[poolSize];
+    volatile size_t queueHead_{0U};
+    volatile size_t queueTail_{0U};
+    volatile size_t poolHead_{0U};
+    volatile size_t poolTail_{0U};
+    volatile bool busy_{false};
+
+    static bool IsBootloaderFlash(const uint8_t* data, size_t size);
+    void Enqueue(const uint8_t* data, uint16_t size, uint16_t poolUsed);
+    uint8_t* AllocatePool(size_t size, uint16_t& poolUsed);
+    void StartNext();
+};
@@ -24,6 +24,9 @@
 #include "BeeCom.h"
 #include "Bootloader.h"
 #include "FlashManager.h"
+#include "UartDmaReceiver.h"
+#include "UartDmaTransmitter.h"
+#include "UartBaudRate.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -43,15 +46,21 @@
 
 /* Private variables ---------------------------------------------------------*/
 UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_usart1_rx;
+DMA_HandleTypeDef hdma_usart1_tx;
 CRC_HandleTypeDef hcrc;
 
 /* USER CODE BEGIN PV */
+UartDmaReceiver uartReceiver(huart1);
+UartDmaTransmitter uartTransmitter(huart1);
+UartBaudRate uartBaudRate(huart1);
 
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
+static void MX_DMA_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_CRC_Init(void);
 /* USER CODE BEGIN PFP */
@@ -92,17 +101,23 @@ int main(void)
 
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
+    MX_DMA_Init();
     MX_USART1_UART_Init();
     MX_CRC_Init();
     /* USER CODE BEGIN 2 */
+    if (!uartReceiver.Start())
+    {
+        Error_Handler();
+    }
+
     auto receive = [](uint8_t *uartRxByte) -> bool
     {
-        return (HAL_UART_Receive(&huart1, uartRxByte, 1, 0) == HAL_OK);
+        return uartReceiver.Read(uartRxByte);
     };
 
     auto transmit = [](const uint8_t *buffer, size_t size)
     {
-        HAL_UART_Transmit(&huart1, const_cast<uint8_t *>(buffer), size, 100);
+        uartTransmitter.Transmit(buffer, size);
     };
 
     constexpr size_t bufferSize = 1024U;
@@ -113,6 +128,10 @@ int main(void)
     FlashManager flashManager;
 
     Bootloader boot(beecom, flashManager);
+    boot.SetTransportHooks({
+        []() { uartTransmitter.Flush(); },
+        [](uint32_t requested) { return uartBaudRate.Resolve(requested); },
+        [](uint32_t baudRate) { return uartBaudRate.Apply(baudRate); }});
     /* USER CODE END 2 */
 
     /* Infinite loop */
@@ -230,6 +249,24 @@ static void MX_USART1_UART_Init(void)
     /* USER CODE END USART1_Init 2 */
 }
 
+/**
+ * Enable DMA controller clock
+ */
+static void MX_DMA_Init(void)
+{
+
+    /* DMA controller clock enable */
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* DMA interrupt init */
+    /* DMA2_Stream2_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream2_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream2_IRQn);
+    /* DMA2_Stream7_IRQn interrupt configuration */
+    HAL_NVIC_SetPriority(DMA2_Stream7_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream7_IRQn);
+}
+
 /**
  * @brief GPIO Initialization Function
  * @param None
@@ -259,7 +296,38 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+extern "C" void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1)
+    {
+        uartTransmitter.OnTransferComplete();
+    }
+}
 
+extern "C" void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1)
+    {
+        uartReceiver.OnHalfTransfer();
+    }
+}
+
+extern "C" void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart == &huart1)
+    {
+        uartReceiver.OnHalfTransfer();
+    }
+}
+
+extern "C" void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    /* Blocking errors abort the circular reception, the main loop restarts it */
+    if ((huart == &huart1) && (huart->RxState == HAL_UART_STATE_READY))
+    {
+        uartReceiver.OnError();
+    }
+}
 /* USER CODE END 4 */
 
 /**
@@ -23,6 +23,18 @@ class PacketType:
     flashMac = 3
     validateFlash = 4
     getBootVersion = 5
+    getAppSignature = 6
+    configureWindow = 7
+    flashDataWindowed = 8
+    setBaudRate = 9
+    confirmBaudRate = 10
+    flashDataCompressed = 11
+    deltaStart = 12
+    deltaData = 13
+    flashFill = 14
+    getSectorDigests = 15
+    getRangeDigest = 16
+    flashManifest = 17
 
 
 class BeeCOMPacket:
@@ -1,6 +1,6 @@
 from PyQt5.QtWidgets import (QApplication, QMainWindow, QTabWidget, QInputDialog, QLineEdit)
 from cryptography.hazmat.primitives import hashes, serialization
-from cryptography.hazmat.primitives.asymmetric import padding, utils, rsa, ec
+from cryptography.hazmat.primitives.asymmetric import padding, utils, rsa, ec, ed25519
 from cryptography.hazmat.primitives.serialization import load_pem_private_key, load_pem_public_key
 from cryptography.hazmat.primitives.serialization import BestAvailableEncryption, NoEncryption
 from cryptography.hazmat.backends import default_backend
@@ -57,7 +57,8 @@ class CryptoManager:
             )
 
     def sign_data(self, data):
-        """Sign data using the loaded private key with PKCS#1 v2.1 PSS padding."""
+        """Sign the 32 byte image digest (SHA-256 or BLAKE2s) with the loaded private key. The SHA-256 prehash
+        label only fixes the digest size and the hash used inside PSS, which is SHA-256 for both digests."""
         if not self.private_key:
             raise ValueError("Private key not loaded.")
         if isinstance(self.private_key, rsa.RSAPrivateKey):
@@ -74,6 +75,9 @@ class CryptoManager:
                 data,
                 ec.ECDSA(utils.Prehashed(hashes.SHA256()))
             )
+        elif isinstance(self.private_key, ed25519.Ed25519PrivateKey):
+            # Plain Ed25519 over the SHA-256 digest, the bootloader checks the digest it computed
+            signature = self.private_key.sign(data)
         else:
             raise TypeError("Unsupported key type")
         
@@ -112,6 +116,10 @@ class CryptoManager:
         )
         return self.serialize_keys(private_key, password)
 
+    def generate_ed25519_key_pair(self, password=None):
+        private_key = ed25519.Ed25519PrivateKey.generate()
+        return self.serialize_keys(private_key, password)
+
     def serialize_keys(self, private_key, password):
         if password:
             if isinstance(password, str):
@@ -120,9 +128,15 @@ class CryptoManager:
         else:
             encryption_algorithm = NoEncryption()
 
+        # Ed25519 keys have no traditional OpenSSL format
+        if isinstance(private_key, ed25519.Ed25519PrivateKey):
+            private_format = serialization.PrivateFormat.PKCS8
+        else:
+            private_format = serialization.PrivateFormat.TraditionalOpenSSL
+
         pem_private_key = private_key.private_bytes(
             encoding=serialization.Encoding.PEM,
-            format=serialization.PrivateFormat.TraditionalOpenSSL,
+            format=private_format,
             encryption_algorithm=encryption_algorithm
         )
         pem_public_key = private_key.public_key().public_bytes(
@@ -0,0 +1,174 @@
+import struct
+
+# STM32F407 flash sectors as (start, size), matching FlashConstants in the bootloader's FlashManager
+FLASH_SECTORS = [(0x08000000, 0x4000), (0x08004000, 0x4000), (0x08008000, 0x4000), (0x0800C000, 0x4000),
+                 (0x08010000, 0x10000)] + [(0x08020000 + i * 0x20000, 0x20000) for i in range(7)]
+# Sector holding the metadata, it is always rebuilt so the metadata is erased for the new image
+METADATA_SECTOR_ADDRESS = 0x0800C000
+# Last sector, the bootloader assembles every patched sector there
+SCRATCH_SECTOR_ADDRESS = 0x080E0000
+
+RECORD_SECTOR_BEGIN = 0x01
+RECORD_COPY = 0x02
+RECORD_INSERT = 0x03
+RECORD_SECTOR_END = 0x04
+
+MIN_COPY_LENGTH = 16
+MAX_RECORD_LENGTH = 0xFFFF
+ERASED_RUN_LENGTH = 8
+MAX_CANDIDATES = 8
+
+
+class DeltaEncoder:
+    """Generates the deltaData records that rebuild the new image from the one installed on the device.
+
+    Sectors are rebuilt in ascending order and each one is assembled from copies of the old image and
+    inserted bytes. Once a sector is replaced its old content is gone, so later copies only read old
+    data from sectors that are still intact, the bootloader refuses anything else.
+    """
+
+    def __init__(self, old_start, old_image, new_start, new_image, max_payload_size):
+        self.old_start = old_start
+        self.old_image = bytes(old_image)
+        self.old_end = old_start + len(old_image)
+        self.new_start = new_start
+        self.new_image = bytes(new_image)
+        self.new_end = new_start + len(new_image)
+        self.max_payload_size = max_payload_size
+        self.replaced = set()
+        self.payloads = []
+        self.current = bytearray()
+
+    def encode(self):
+        """Return the list of deltaData payloads."""
+        if self.old_end > SCRATCH_SECTOR_ADDRESS or self.new_end > SCRATCH_SECTOR_ADDRESS:
+            raise ValueError("Images reaching into the scratch sector can only be flashed in full.")
+
+        self._index_old_image()
+        for start, size in FLASH_SECTORS:
+            if start + size <= METADATA_SECTOR_ADDRESS or start >= self.new_end:
+                continue
+            content = self._new_sector_content(start, size)
+            if start != METADATA_SECTOR_ADDRESS and content == self._old_sector_content(start, size):
+                continue
+            self._encode_sector(start, content)
+            self.replaced.add(start)
+
+        if self.current:
+            self.payloads.append(bytes(self.current))
+        return self.payloads
+
+    def _index_old_image(self):
+        self.index = {}
+        for offset in range(len(self.old_image) - MIN_COPY_LENGTH + 1):
+            key = self.old_image[offset:offset + MIN_COPY_LENGTH]
+            positions = self.index.setdefault(key, [])
+            if len(positions) < MAX_CANDIDATES:
+                positions.append(self.old_start + offset)
+
+    def _new_sector_content(self, start, size):
+        content = bytearray(b'\xFF' * size)
+        low = max(start, self.new_start)
+        high = min(start + size, self.new_end)
+        if low < high:
+            content[low - start:high - start] = self.new_image[low - self.new_start:high - self.new_start]
+        return bytes(content)
+
+    def _old_sector_content(self, start, size):
+        """Old sector content, None where the device holds bytes outside the known old image."""
+        if start < self.old_start or start + size > self.old_end:
+            return None
+        return self.old_image[start - self.old_start:start + size - self.old_start]
+
+    def _intact_end(self, address):
+        """End of the old data readable from address, stopping at the first sector replaced already."""
+        end = address
+        for start, size in FLASH_SECTORS:
+            if start + size <= address:
+                continue
+            if start in self.replaced:
+                break
+            end = start + size
+        return min(end, self.old_end)
+
+    def _match_length(self, source, content, offset, limit):
+        length = 0
+        old = self.old_image
+        base = source - self.old_start
+        while length < limit:
+            step = min(256, limit - length)
+            if old[base + length:base + length + step] == content[offset + length:offset + length + step]:
+                length += step
+                continue
+            while length < limit and old[base + length] == content[offset + length]:
+                length += 1
+            break
+        return length
+
+    def _find_copy(self, address, content, offset):
+        candidates = list(self.index.get(content[offset:offset + MIN_COPY_LENGTH], []))
+        # Unchanged code usually sits at the same address, try that first
+        if self.old_start <= address < self.old_end:
+            candidates.insert(0, address)
+
+        best_source, best_length = None, 0
+        for source in candidates:
+            limit = min(len(content) - offset, self._intact_end(source) - source, MAX_RECORD_LENGTH)
+            if limit < MIN_COPY_LENGTH:
+                continue
+            length = self._match_length(source, content, offset, limit)
+            if length > best_length:
+                best_source, best_length = source, length
+        return best_source, best_length
+
+    def _encode_sector(self, start, content):
+        self._append_record(struct.pack('>BI', RECORD_SECTOR_BEGIN, start))
+        offset = 0
+        literal_start = None
+
+        while offset < len(content):
+            if content[offset:offset + ERASED_RUN_LENGTH] == b'\xFF' * ERASED_RUN_LENGTH:
+                # The scratch sector is erased, runs of 0xFF are skipped instead of sent
+                self._append_insert(start, content, literal_start, offset)
+                literal_start = None
+                while offset < len(content) and content[offset] == 0xFF:
+                    offset += 1
+                continue
+
+            source, length = self._find_copy(start + offset, content, offset)
+            if length >= MIN_COPY_LENGTH:
+                self._append_insert(start, content, literal_start, offset)
+                literal_start = None
+                self._append_record(struct.pack('>BIIH', RECORD_COPY, start + offset, source, length))
+                offset += length
+                continue
+
+            if literal_start is None:
+                literal_start = offset
+            offset += 1
+
+        self._append_insert(start, content, literal_start, len(content))
+        self._append_record(bytes([RECORD_SECTOR_END]))
+
+    def _append_insert(self, sector_start, content, literal_start, literal_end):
+        if literal_start is None:
+            return
+        header_size = struct.calcsize('>BIH')
+        while literal_start < literal_end:
+            room = self.max_payload_size - len(self.current) - header_size
+            if room <= 0:
+                self._start_payload()
+                continue
+            length = min(room, literal_end - literal_start, MAX_RECORD_LENGTH)
+            self.current += struct.pack('>BIH', RECORD_INSERT, sector_start + literal_start, length)
+            self.current += content[literal_start:literal_start + length]
+            literal_start += length
+
+    def _append_record(self, record):
+        if len(self.current) + len(record) > self.max_payload_size:
+            self._start_payload()
+        self.current += record
+
+    def _start_payload(self):
+        self.payloads.append(bytes(self.current))
+        self.current = bytearray()
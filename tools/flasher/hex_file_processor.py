@@ -1,6 +1,40 @@
 from hexrec.formats.ihex import IhexFile, IhexRecord
 from cryptography.hazmat.primitives import hashes
 import logging
+import re
+import struct
+
+LZ4_MIN_MATCH = 4
+LZ4_LAST_LITERALS = 5
+LZ4_MATCH_FIND_LIMIT = 12
+LZ4_MAX_OFFSET = 0xFFFF
+
+CRC32_POLYNOMIAL = 0x04C11DB7
+
+# Image digest algorithms, in line with IMAGE_DIGEST_BLAKE2S in BootConfig.h
+IMAGE_DIGEST_SHA256 = "SHA-256"
+IMAGE_DIGEST_BLAKE2S = "BLAKE2s"
+IMAGE_DIGESTS = (IMAGE_DIGEST_SHA256, IMAGE_DIGEST_BLAKE2S)
+
+# Merkle manifest, in line with MerkleManifest and BootConfig::maxManifestBlocks
+MANIFEST_MIN_BLOCK_SIZE_LOG2 = 12
+MANIFEST_MAX_BLOCK_SIZE_LOG2 = 14
+MANIFEST_MAX_BLOCKS = 64
+MANIFEST_LEAF_PREFIX = b'\x00'
+MANIFEST_NODE_PREFIX = b'\x01'
+
+
+def _crc32_table():
+    table = []
+    for byte in range(256):
+        crc = byte << 24
+        for _ in range(8):
+            crc = ((crc << 1) ^ CRC32_POLYNOMIAL) if crc & 0x80000000 else crc << 1
+        table.append(crc & 0xFFFFFFFF)
+    return table
+
+
+CRC32_TABLE = _crc32_table()
 
 class HexFileProcessor:
     def __init__(self, file_path):
@@ -30,8 +64,14 @@ class HexFileProcessor:
             base_address = int.from_bytes(record.data, byteorder='big') << 4
         return base_address
 
-    def calculate_hash(self):
-        """Calculate SHA-256 hash of the hex file from min_address to max_address, filling gaps with 0xFF."""
+    def calculate_hash(self, algorithm=IMAGE_DIGEST_SHA256):
+        """Calculate the digest (SHA-256 or BLAKE2s-256) of the hex file from min_address to max_address, filling
+        gaps with 0xFF."""
+        _, full_data = self.build_image()
+        return self._compute_digest(full_data, algorithm)
+
+    def build_image(self):
+        """Return the start address and the contiguous image from min_address to max_address, gaps filled with 0xFF."""
         if not self.ihex:
             raise ValueError("No hex file loaded.")
 
@@ -49,8 +89,7 @@ class HexFileProcessor:
         max_address = max(addr + len(data) for addr, data in data_map.items())
         logging.debug(f"Min address: {min_address}, Max address: {max_address}")
 
-        full_data = self._create_full_data(data_map, min_address, max_address)
-        return self._compute_sha256(full_data)
+        return min_address, self._create_full_data(data_map, min_address, max_address)
 
     def _create_full_data(self, data_map, min_address, max_address):
         full_data = bytearray((max_address - min_address) * [0xFF])
@@ -59,13 +98,155 @@ class HexFileProcessor:
             full_data[start_index:start_index + len(data)] = data
         return full_data
 
-    def _compute_sha256(self, data):
-        hash_context = hashes.Hash(hashes.SHA256())
+    def build_manifest(self, algorithm=IMAGE_DIGEST_SHA256, max_blocks=MANIFEST_MAX_BLOCKS):
+        """Return (start, end, block_size_log2, leaves, root) of the Merkle manifest over the image, with the
+        smallest block size that needs at most max_blocks leaves. Leaves and nodes are hashed as in RFC 6962."""
+        start, image = self.build_image()
+        for block_size_log2 in range(MANIFEST_MIN_BLOCK_SIZE_LOG2, MANIFEST_MAX_BLOCK_SIZE_LOG2 + 1):
+            block_size = 1 << block_size_log2
+            if -(-len(image) // block_size) <= max_blocks:
+                break
+        else:
+            raise ValueError(f"Image needs more than {max_blocks} manifest blocks.")
+
+        leaves = [self._compute_digest(MANIFEST_LEAF_PREFIX + bytes(image[offset:offset + block_size]), algorithm)
+                  for offset in range(0, len(image), block_size)]
+        return start, start + len(image), block_size_log2, leaves, self._merkle_root(leaves, algorithm)
+
+    def _merkle_root(self, leaves, algorithm):
+        if len(leaves) == 1:
+            return leaves[0]
+        # The left subtree holds the largest power of two below the leaf count
+        split = 1
+        while split * 2 < len(leaves):
+            split *= 2
+        children = self._merkle_root(leaves[:split], algorithm) + self._merkle_root(leaves[split:], algorithm)
+        return self._compute_digest(MANIFEST_NODE_PREFIX + children, algorithm)
+
+    def _compute_digest(self, data, algorithm):
+        if algorithm == IMAGE_DIGEST_BLAKE2S:
+            hash_context = hashes.Hash(hashes.BLAKE2s(32))
+        elif algorithm == IMAGE_DIGEST_SHA256:
+            hash_context = hashes.Hash(hashes.SHA256())
+        else:
+            raise ValueError(f"Unsupported image digest {algorithm}.")
         hash_context.update(data)
         return hash_context.finalize()
 
+    @staticmethod
+    def calculate_crc32(data):
+        """CRC-32 as computed by the STM32 CRC unit: little-endian words shifted in MSB first, no reflection,
+        no final XOR, a partial last word padded with 0xFF."""
+        data = bytes(data) + b'\xFF' * (-len(data) % 4)
+        word_count = len(data) // 4
+        data = struct.pack(f'>{word_count}I', *struct.unpack(f'<{word_count}I', data))
+        crc = 0xFFFFFFFF
+        for byte in data:
+            crc = ((crc << 8) & 0xFFFFFFFF) ^ CRC32_TABLE[(crc >> 24) ^ byte]
+        return crc
+
     @staticmethod
     def chunk_data(data, chunk_size):
         """Yield successive chunk_size chunks from data."""
         for i in range(0, len(data), chunk_size):
-            yield data[i:i + chunk_size]
\ No newline at end of file
+            yield data[i:i + chunk_size]
+
+    @staticmethod
+    def merge_contiguous(data_blocks):
+        """Join address-contiguous blocks into (address, bytes) runs."""
+        runs = []
+        for address, data in data_blocks:
+            if runs and runs[-1][0] + len(runs[-1][1]) == address:
+                runs[-1][1].extend(data)
+            else:
+                runs.append((address, bytearray(data)))
+        return [(address, bytes(data)) for address, data in runs]
+
+    @staticmethod
+    def clip_blocks(data_blocks, ranges):
+        """Keep only the parts of the blocks that fall into the (start, size) ranges."""
+        clipped = []
+        for address, data in data_blocks:
+            for start, size in ranges:
+                low = max(address, start)
+                high = min(address + len(data), start + size)
+                if low < high:
+                    clipped.append((low, data[low - address:high - address]))
+        return sorted(clipped, key=lambda block: block[0])
+
+    @staticmethod
+    def split_constant_runs(data_blocks, min_run_length):
+        """Separate runs of at least min_run_length equal bytes from the data.
+        Returns the remaining (address, bytes) runs and the (address, length, pattern) fills."""
+        pattern = re.compile(rb'(.)\1{%d,}' % (min_run_length - 1), re.DOTALL)
+        data_runs = []
+        fills = []
+        for address, data in HexFileProcessor.merge_contiguous(data_blocks):
+            position = 0
+            for match in pattern.finditer(data):
+                if match.start() > position:
+                    data_runs.append((address + position, data[position:match.start()]))
+                fills.append((address + match.start(), match.end() - match.start(), data[match.start()]))
+                position = match.end()
+            if position < len(data):
+                data_runs.append((address + position, data[position:]))
+        return data_runs, fills
+
+    @staticmethod
+    def compress_blocks(data_blocks, chunk_size):
+        """Cut the image into chunk_size pieces and LZ4-compress each one on its own, so every piece can be
+        decompressed without the ones before it. Yields (address, raw, compressed) tuples."""
+        for address, data in HexFileProcessor.merge_contiguous(data_blocks):
+            for chunk in HexFileProcessor.chunk_data(data, chunk_size):
+                yield address, chunk, HexFileProcessor.compress_lz4_block(chunk)
+                address += len(chunk)
+
+    @staticmethod
+    def compress_lz4_block(data):
+        """Compress data into one LZ4 block (raw block format, no frame) with a greedy single-entry hash table."""
+        data = bytes(data)
+        out = bytearray()
+        table = {}
+        anchor = 0
+        position = 0
+        match_find_end = len(data) - LZ4_MATCH_FIND_LIMIT
+        match_end = len(data) - LZ4_LAST_LITERALS
+
+        while position < match_find_end:
+            key = data[position:position + LZ4_MIN_MATCH]
+            candidate = table.get(key)
+            table[key] = position
+            if candidate is None or position - candidate > LZ4_MAX_OFFSET:
+                position += 1
+                continue
+
+            length = LZ4_MIN_MATCH
+            while position + length < match_end and data[candidate + length] == data[position + length]:
+                length += 1
+
+            HexFileProcessor._append_lz4_sequence(out, data[anchor:position], position - candidate, length)
+            position += length
+            anchor = position
+
+        HexFileProcessor._append_lz4_sequence(out, data[anchor:], 0, 0)
+        return bytes(out)
+
+    @staticmethod
+    def _append_lz4_sequence(out, literals, offset, match_length):
+        """Append a token, the literals and, unless this is the closing sequence, the match."""
+        match_code = match_length - LZ4_MIN_MATCH if match_length else 0
+        out.append((min(len(literals), 15) << 4) | min(match_code, 15))
+        if len(literals) >= 15:
+            HexFileProcessor._append_lz4_length(out, len(literals) - 15)
+        out += literals
+        if match_length:
+            out += struct.pack('<H', offset)
+            if match_code >= 15:
+                HexFileProcessor._append_lz4_length(out, match_code - 15)
+
+    @staticmethod
+    def _append_lz4_length(out, remainder):
+        while remainder >= 255:
+            out.append(255)
+            remainder -= 255
+        out.append(remainder)
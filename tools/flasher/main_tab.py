@@ -1,11 +1,12 @@
 import logging
+import struct
 from PyQt5.QtWidgets import (QPushButton, QVBoxLayout, QHBoxLayout,
                              QWidget, QFileDialog, QLabel, QLineEdit, QTextEdit, QComboBox, QStatusBar,
-                             QProgressBar, QMessageBox)
+                             QProgressBar, QMessageBox, QCheckBox)
 from PyQt5.QtCore import Qt
 from uart_com import UARTCommunication
 from crypto_manager import CryptoManager
-from hex_file_processor import HexFileProcessor
+from hex_file_processor import HexFileProcessor, IMAGE_DIGESTS
 from qt_threads import FlashFirmwareThread, EraseFirmwareThread
 from beecom_packet import BeeCOMPacket, PacketType
 
@@ -28,8 +29,11 @@ class MainTab(QWidget):
         self.uart_comm = UARTCommunication()
         self.crypto_manager = CryptoManager()
         self.hex_processor = None
+        self.base_hex_processor = None
         self.firmware_erased = False
         self.bootloader_version = None
+        self.manifest_root = None
+        self.pending_erase_sectors = 0
         self.setupUI()
 
     def setupUI(self):
@@ -72,6 +76,9 @@ class MainTab(QWidget):
         self.file_button = QPushButton('Select .hex File', self)
         self.file_button.clicked.connect(self.select_hex_file)
         file_layout.addWidget(self.file_button)
+        self.base_file_button = QPushButton('Select installed .hex (delta update)', self)
+        self.base_file_button.clicked.connect(self.select_base_hex_file)
+        file_layout.addWidget(self.base_file_button)
         self.private_key_button = QPushButton('Load Key', self)
         self.private_key_button.clicked.connect(self.load_key)
         file_layout.addWidget(self.private_key_button)
@@ -84,6 +91,18 @@ class MainTab(QWidget):
         self.erase_button = self.setupActionButton(layout, 'Erase firmware', self.erase_firmware, False)
         self.flash_button = self.setupActionButton(layout, 'Flash firmware', self.flash_firmware, False)
         self.verify_button = self.setupActionButton(layout, 'Validate application', self.validate_app, False)
+        self.incremental_check_box = QCheckBox('Changed sectors only', self)
+        self.incremental_check_box.setToolTip('Compare sector digests with the device and reprogram only what differs')
+        layout.addWidget(self.incremental_check_box)
+        self.manifest_check_box = QCheckBox('Merkle manifest', self)
+        self.manifest_check_box.setToolTip('Signed block digests, the bootloader checks every block as it arrives')
+        layout.addWidget(self.manifest_check_box)
+        self.image_digest_label = QLabel("Image digest:", self)
+        self.image_digest_combo = QComboBox(self)
+        self.image_digest_combo.addItems(IMAGE_DIGESTS)
+        self.image_digest_combo.setToolTip('Digest the signature covers, as IMAGE_DIGEST_BLAKE2S in BootConfig.h')
+        layout.addWidget(self.image_digest_label)
+        layout.addWidget(self.image_digest_combo)
         main_layout.addLayout(layout)
 
     def setupActionButton(self, layout, title, method, enabled=True):
@@ -121,6 +140,13 @@ class MainTab(QWidget):
         layout.addWidget(self.baud_rate_label)
         layout.addWidget(self.baud_rate_input)
 
+        self.session_baud_label = QLabel("Flashing baud rate:", self)
+        self.session_baud_combo = QComboBox(self)
+        self.session_baud_combo.setEditable(True)
+        self.session_baud_combo.addItems(["Off", "921600", "2000000", "Max"])
+        layout.addWidget(self.session_baud_label)
+        layout.addWidget(self.session_baud_combo)
+
     def setupConnectButton(self, layout):
         self.connect_button = QPushButton('Connect', self)
         self.connect_button.clicked.connect(self.connect_to_device)
@@ -174,6 +200,22 @@ class MainTab(QWidget):
             except Exception as e:
                 self.log(f"Failed to load HEX file: {e}", level=logging.ERROR)
 
+    def select_base_hex_file(self):
+        """Select the image currently installed on the device, flashing then sends only a patch against it."""
+        file_name, _ = QFileDialog.getOpenFileName(self, "Open installed HEX file", "", "HEX files (*.hex)")
+        if not file_name:
+            self.base_hex_processor = None
+            self.log("Delta update disabled, the full image will be flashed.")
+            return
+        try:
+            base_hex_processor = HexFileProcessor(file_name)
+            base_hex_processor.load_and_process_hex_file()
+            self.base_hex_processor = base_hex_processor
+            self.log("Installed HEX file loaded, flashing will send a delta update.")
+        except Exception as e:
+            self.base_hex_processor = None
+            self.log(f"Failed to load installed HEX file: {e}", level=logging.ERROR)
+
     def load_key(self):
         """Load a private key from a .pem file using a file dialog."""
         file_name, _ = QFileDialog.getOpenFileName(self, "Open Private Key File", "", "PEM files (*.pem)")
@@ -200,33 +242,72 @@ class MainTab(QWidget):
             QMessageBox.critical(self, "Error", "Failed to connect to the device.")
             self.enable_flashing_buttons(False)
 
+    def session_baud_rate(self):
+        """Baud rate to negotiate before flashing, None keeps the connection rate and 0 asks for the fastest."""
+        text = self.session_baud_combo.currentText().strip()
+        if text == "Off":
+            return None
+        if text == "Max":
+            return 0
+        return int(text)
+
     def erase_firmware(self):
         self.log("Initiating firmware erase...")
-        self.erase_thread = EraseFirmwareThread(self.uart_comm)
+        self.erase_thread = EraseFirmwareThread(self.uart_comm, self.hex_processor)
         self.erase_thread.finished.connect(self.on_erase_finished)
         self.erase_thread.start()
 
     def on_erase_finished(self, success, message):
         if success:
             self.firmware_erased = True
+            # Erased in the background, the flash thread allows for them in its timeouts
+            self.pending_erase_sectors = self.erase_thread.sector_count
             self.log(message)
         else:
             self.log(message, level=logging.ERROR)
             self.show_error_message(message)
 
     def flash_firmware(self):
-        if not self.firmware_erased:
+        incremental = self.incremental_check_box.isChecked()
+        if self.base_hex_processor is None and not incremental and not self.firmware_erased:
             self.log("Firmware not erased, erasing now...")
             self.erase_firmware()
             if not self.firmware_erased:
                 return
 
-        self.flash_thread = FlashFirmwareThread(self.hex_processor, self.uart_comm)
+        try:
+            manifest = self.build_signed_manifest()
+        except Exception as e:
+            self.log(f"Failed to build the manifest: {e}", level=logging.ERROR)
+            self.show_error_message(f"Manifest error: {e}")
+            return
+
+        self.flash_thread = FlashFirmwareThread(self.hex_processor, self.uart_comm, self.session_baud_rate(),
+                                                self.base_hex_processor, incremental, manifest,
+                                                self.pending_erase_sectors)
         self.flash_thread.progress_max.connect(self.flash_progress_bar.setMaximum)
         self.flash_thread.update_progress.connect(self.flash_progress_bar.setValue)
         self.flash_thread.log_message.connect(self.log)
         self.flash_thread.start()
 
+    def build_signed_manifest(self):
+        """Leaves and signed root for the flash thread, None without "Merkle manifest". The root is kept because
+        validation has to sign it again instead of the image digest."""
+        self.manifest_root = None
+        if not self.manifest_check_box.isChecked():
+            return None
+        if self.base_hex_processor is not None:
+            self.log("Delta updates are flashed without a manifest.")
+            return None
+        if not self.crypto_manager.private_key:
+            raise ValueError("Private key not loaded, the manifest is signed before flashing.")
+
+        start, end, block_size_log2, leaves, root = self.hex_processor.build_manifest(
+            self.image_digest_combo.currentText())
+        signature = self.crypto_manager.sign_data(root)
+        self.manifest_root = root
+        return start, end, block_size_log2, leaves, signature
+
     def validate_app(self):
         try:
             self.log("Starting the application validation process...")
@@ -236,7 +317,10 @@ class MainTab(QWidget):
             if not self.crypto_manager.private_key:
                 raise ValueError("Private key not loaded. Please load a private key first.")
 
-            file_hash = self.hex_processor.calculate_hash()
+            # With a manifest the signature covers its root instead of the image digest
+            file_hash = self.manifest_root
+            if file_hash is None:
+                file_hash = self.hex_processor.calculate_hash(self.image_digest_combo.currentText())
 
             signature = self.crypto_manager.sign_data(file_hash)
             self.log(f"Signature generated: {signature.hex()}")
@@ -249,10 +333,15 @@ class MainTab(QWidget):
             response = self.uart_comm.receive_packet(timeout=10)
             response_packet, crc_received = BeeCOMPacket.parse_packet(response)
 
-            if not response_packet.validate_packet(crc_received, PacketType.validateFlash, self.ACK_PACKET):
+            response_packet.validate_packet(crc_received, PacketType.validateFlash)
+            if response_packet.payload[:1] != self.ACK_PACKET or len(response_packet.payload) not in (1, 5):
                 raise ValueError("Validation packet validation failed.")
 
             self.log("Application validated successfully.")
+            # Newer bootloaders append the core cycles of the signature verify
+            if len(response_packet.payload) == 5:
+                cycles = struct.unpack('>I', response_packet.payload[1:])[0]
+                self.log(f"Signature verify took {cycles} cycles.")
 
         except Exception as e:
             self.log(f"Failed to validate application: {e}", level=logging.ERROR)
@@ -0,0 +1,49 @@
+import sys
+from cryptography.hazmat.primitives.asymmetric import rsa, ec, ed25519
+from cryptography.hazmat.primitives.serialization import load_pem_public_key, Encoding, PublicFormat
+
+BYTES_PER_LINE = 12
+
+
+def _format_array(name, data):
+    lines = []
+    for offset in range(0, len(data), BYTES_PER_LINE):
+        chunk = data[offset:offset + BYTES_PER_LINE]
+        lines.append('    ' + ', '.join(f'0x{byte:02X}U' for byte in chunk) + ',')
+    return f'constexpr uint8_t {name}[] = {{\n' + '\n'.join(lines) + '\n};'
+
+
+def format_public_key(pem_public_key):
+    """Return the BootConfig.h constants of a PEM public key, the bootloader takes the key in raw form."""
+    public_key = load_pem_public_key(pem_public_key)
+
+    if isinstance(public_key, ec.EllipticCurvePublicKey):
+        if not isinstance(public_key.curve, ec.SECP256R1):
+            raise ValueError(f"Unsupported curve {public_key.curve.name}, the bootloader verifies SECP256R1 only.")
+        point = public_key.public_bytes(Encoding.X962, PublicFormat.UncompressedPoint)
+        return '/* SECP256R1 point, 0x04 || X || Y */\n' + _format_array('publicKey', point)
+
+    if isinstance(public_key, ed25519.Ed25519PublicKey):
+        raw_key = public_key.public_bytes(Encoding.Raw, PublicFormat.Raw)
+        return '/* Ed25519 key, RFC 8032 encoding */\n' + _format_array('publicKey', raw_key)
+
+    if isinstance(public_key, rsa.RSAPublicKey):
+        numbers = public_key.public_numbers()
+        modulus = numbers.n.to_bytes((numbers.n.bit_length() + 7) // 8, 'big')
+        exponent = numbers.e.to_bytes((numbers.e.bit_length() + 7) // 8, 'big')
+        # Montgomery constant R^2 mod N of mbedtls, R = 2^(32 * number of 32-bit limbs of N)
+        limb_bits = 32 * ((len(modulus) + 3) // 4)
+        montgomery_rr = pow(2, 2 * limb_bits, numbers.n).to_bytes(len(modulus), 'big')
+        return ('/* RSA modulus, public exponent and R^2 mod N for the Montgomery multiplication, big-endian */\n' +
+                _format_array('publicKeyModulus', modulus) + '\n' + _format_array('publicKeyExponent', exponent) +
+                '\n' + _format_array('publicKeyMontgomeryRR', montgomery_rr))
+
+    raise ValueError("Unsupported public key type.")
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        print(f"Usage: {sys.argv[0]} <public key .pem>")
+        sys.exit(1)
+    with open(sys.argv[1], 'rb') as key_file:
+        print(format_public_key(key_file.read()))
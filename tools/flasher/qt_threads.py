@@ -1,35 +1,84 @@
 from PyQt5.QtCore import QThread, pyqtSignal
 from beecom_packet import BeeCOMPacket, PacketType
 from hex_file_processor import HexFileProcessor
+from delta_encoder import DeltaEncoder, FLASH_SECTORS, METADATA_SECTOR_ADDRESS
+import hashlib
 import logging
 import struct
+import time
 
 ACK_PACKET = b'\x55'
+ACK_VALUE = 0x55
+REQUESTED_WINDOW_SIZE = 16
+WINDOW_RESPONSE_TIMEOUT = 5
+MAX_RETRANSMISSIONS = 5
+MAX_PAYLOAD_SIZE = 512
+# The bootloader reverts a baud rate change if no probe reaches it within 500 ms
+BAUD_PROBE_ATTEMPTS = 3
+BAUD_PROBE_TIMEOUT = 0.1
+BAUD_FALLBACK_DELAY = 0.6
+# Compressed packets must fit the bootloader's 1024 byte packet buffer and its decompression buffer
+CAPABILITY_COMPRESSED_DATA = 0x01
+CAPABILITY_FILL = 0x02
+# Constant runs at least this long go out as a flashFill packet instead of data
+FILL_THRESHOLD = 64
+COMPRESSED_CHUNK_SIZE = 2048
+MAX_PACKET_PAYLOAD = 1024
+WINDOWED_HEADER_SIZE = 6
+# Every deltaData packet may erase the scratch and a target sector, 128 KB each
+DELTA_RESPONSE_TIMEOUT = 10
+# Erasing a 128 KB sector takes up to 2 s on the F407
+ERASE_TIMEOUT_BASE = 2
+ERASE_TIMEOUT_PER_SECTOR = 2
+# setBaudRate and configureWindow, the device may be stalled by the background erase of every sector still pending
+NEGOTIATION_TIMEOUT = 2
+SECTOR_DIGEST_ENTRY = struct.Struct('>II32s')
+# flashManifest: [start][end][block size log2][first leaf], checking the signature may wait for a sector erase
+MANIFEST_HEADER_SIZE = 11
+MANIFEST_RESPONSE_TIMEOUT = 5
+RANGE_DIGEST_CRC32 = 0
 
 class FlashFirmwareThread(QThread):
     update_progress = pyqtSignal(int)
     progress_max = pyqtSignal(int)
     log_message = pyqtSignal(str)
 
-    def __init__(self, hex_processor, uart_comm):
+    def __init__(self, hex_processor, uart_comm, session_baud_rate=None, base_hex_processor=None, incremental=False,
+                 manifest=None, pending_erase_sectors=0):
         super().__init__()
+        self.pending_erase_sectors = pending_erase_sectors
+        self.incremental = incremental
+        self.manifest = manifest
         self.hex_processor = hex_processor
         self.uart_comm = uart_comm
+        self.session_baud_rate = session_baud_rate
+        self.base_hex_processor = base_hex_processor
 
     def run(self):
         try:
+            if self.session_baud_rate is not None:
+                self._switch_baud_rate(self.session_baud_rate)
             data_blocks = self.hex_processor.load_and_process_hex_file()
-            self._flash_data_blocks(data_blocks)
+            if self.base_hex_processor is not None:
+                self._flash_delta()
+            elif self.incremental:
+                self._flash_incremental(data_blocks)
+            else:
+                self._flash_data_blocks(data_blocks)
+            self._verify_image()
         except Exception as e:
             self.log_message.emit(f"Error: {str(e)}")
             raise
 
-    def _flash_data_blocks(self, data_blocks):
-        max_payload_size = 512
+    def _flash_data_blocks(self, data_blocks, app_range=None):
+        if self.manifest is not None:
+            self._send_manifest()
+
+        max_payload_size = MAX_PAYLOAD_SIZE
         total_size = sum(len(data) for _, data in data_blocks)
         self.progress_max.emit(total_size)
 
-        current_size = 0
+        merged_blocks = []
         merged_data = []
         merged_address = None
 
@@ -44,12 +93,28 @@ class FlashFirmwareThread(QThread):
             if self._can_merge_data(merged_address, address, merged_data, data, max_payload_size):
                 merged_data.extend(data)
             else:
-                current_size = self._send_and_update_progress(merged_address, merged_data, current_size)
+                if merged_data:
+                    merged_blocks.append((merged_address, merged_data))
                 merged_address = address
                 merged_data = list(data)
 
         if merged_data:
-            size = self._send_and_update_progress(merged_address, merged_data, current_size)
+            merged_blocks.append((merged_address, merged_data))
+
+        if app_range is not None:
+            app_start_address, app_end_address = app_range
+
+        if merged_blocks:
+            window_size, capabilities = self._negotiate_window()
+            if window_size > 0:
+                # In address order, so the bootloader sees every manifest block in one run
+                packets = self._build_windowed_packets(data_blocks, capabilities)
+                packets.sort(key=lambda packet: packet[1])
+                size = self._send_windowed(packets, window_size)
+            else:
+                size = 0
+                for address, data in merged_blocks:
+                    size = self._send_and_update_progress(address, data, size)
             self.log_message.emit(f"Firmware flashed successfully. Bytes sent: {size}")
 
         if app_start_address is not None and app_end_address is not None:
@@ -57,6 +122,21 @@ class FlashFirmwareThread(QThread):
         else:
             raise ValueError("Could not determine application start and end addresses from data blocks.")
 
+    def _send_manifest(self):
+        """Send the manifest leaves and the signature of its root, the bootloader then checks every block as it
+        arrives instead of only the whole image at validation."""
+        start, end, block_size_log2, leaves, signature = self.manifest
+        header = struct.pack('>IIB', start, end, block_size_log2)
+        leaves_per_packet = (MAX_PACKET_PAYLOAD - MANIFEST_HEADER_SIZE) // len(leaves[0])
+
+        for first in range(0, len(leaves), leaves_per_packet):
+            payload = header + struct.pack('>H', first) + b''.join(leaves[first:first + leaves_per_packet])
+            self._send_expecting_ack(PacketType.flashManifest, payload, MANIFEST_RESPONSE_TIMEOUT)
+
+        payload = header + struct.pack('>H', len(leaves)) + signature
+        self._send_expecting_ack(PacketType.flashManifest, payload, MANIFEST_RESPONSE_TIMEOUT)
+        self.log_message.emit(f"Manifest accepted: {len(leaves)} blocks of {1 << block_size_log2} bytes.")
+
     def _can_merge_data(self, merged_address, address, merged_data, data, max_payload_size):
         return (merged_address is not None
                 and address == merged_address + len(merged_data)
@@ -102,12 +182,271 @@ class FlashFirmwareThread(QThread):
             address += len(chunk)
             logging.debug(f"Sent data chunk to address {address}.")
 
+    def _flash_incremental(self, data_blocks):
+        """Erase and reprogram only the sectors whose digest on the device differs from the new image."""
+        image_start, image = self.hex_processor.build_image()
+        image_end = image_start + len(image)
+        sectors = self._read_sector_digests()
+
+        # The first application sector holds the metadata, it is erased and rewritten in any case
+        metadata_sector = sectors[0][:2]
+        changed = []
+        for start, size, digest in sectors[1:]:
+            if start >= image_end or start + size <= image_start:
+                continue
+            content = bytearray(b'\xFF' * size)
+            low, high = max(start, image_start), min(start + size, image_end)
+            content[low - start:high - start] = image[low - image_start:high - image_start]
+            if hashlib.sha256(content).digest() != digest:
+                changed.append((start, size))
+
+        self.log_message.emit(f"Sectors to update: {len(changed)} changed plus the metadata sector.")
+        # The metadata sector is always listed, flashStart without ranges would erase the whole application
+        updated = [metadata_sector] + changed
+        ranges = b''.join(struct.pack('>II', start, start + size - 1) for start, size in updated)
+        self._send_expecting_ack(PacketType.flashStart, ranges,
+                                 ERASE_TIMEOUT_BASE + ERASE_TIMEOUT_PER_SECTOR * len(updated))
+        self.pending_erase_sectors = len(updated)
+
+        blocks = HexFileProcessor.clip_blocks(data_blocks, updated)
+        self._flash_data_blocks(blocks, (image_start, image_end))
+
+    def _verify_image(self):
+        """Compare the hardware CRC of the programmed range with the image instead of reading it back."""
+        image_start, image = self.hex_processor.build_image()
+        payload = struct.pack('>BII', RANGE_DIGEST_CRC32, image_start, len(image))
+        packet = BeeCOMPacket(packet_type=PacketType.getRangeDigest, payload=payload).create_packet()
+        self.uart_comm.send_packet(packet)
+
+        response_packet, crc_received = BeeCOMPacket.parse_packet(self.uart_comm.receive_frame(timeout=5))
+        response_packet.validate_packet(crc_received, PacketType.getRangeDigest)
+        if len(response_packet.payload) != 5 or response_packet.payload[0] != ACK_VALUE:
+            self.log_message.emit("Bootloader cannot report range digests, programmed data not verified.")
+            return
+
+        device_crc = struct.unpack('>I', response_packet.payload[1:])[0]
+        expected_crc = HexFileProcessor.calculate_crc32(image)
+        if device_crc != expected_crc:
+            raise ValueError(f"Verification failed: device CRC {device_crc:08X}, image CRC {expected_crc:08X}.")
+        self.log_message.emit(f"Programmed data verified, CRC32 {device_crc:08X}.")
+
+    def _read_sector_digests(self):
+        """Return (start, size, sha256) of every application sector as reported by the bootloader."""
+        packet = BeeCOMPacket(packet_type=PacketType.getSectorDigests).create_packet()
+        self.uart_comm.send_packet(packet)
+
+        response_packet, crc_received = BeeCOMPacket.parse_packet(self.uart_comm.receive_frame(timeout=10))
+        response_packet.validate_packet(crc_received, PacketType.getSectorDigests)
+        payload = response_packet.payload
+        if not payload or len(payload) % SECTOR_DIGEST_ENTRY.size:
+            raise ValueError("Bootloader does not report sector digests.")
+        return list(SECTOR_DIGEST_ENTRY.iter_unpack(payload))
+
+    def _flash_delta(self):
+        """Patch the installed image into the new one, only the changed sectors are rebuilt on the device."""
+        old_start, old_image = self.base_hex_processor.build_image()
+        new_start, new_image = self.hex_processor.build_image()
+        new_end = new_start + len(new_image)
+        payloads = DeltaEncoder(old_start, old_image, new_start, new_image, MAX_PACKET_PAYLOAD).encode()
+        self.progress_max.emit(len(payloads))
+
+        start_payload = self.base_hex_processor.calculate_hash() + struct.pack('>II', new_start, new_end)
+        self._send_expecting_ack(PacketType.deltaStart, start_payload, DELTA_RESPONSE_TIMEOUT)
+
+        for count, payload in enumerate(payloads, start=1):
+            self._send_expecting_ack(PacketType.deltaData, payload, DELTA_RESPONSE_TIMEOUT)
+            self.update_progress.emit(count)
+
+        self.log_message.emit(f"Delta applied. Bytes sent: {sum(len(p) for p in payloads)} for a {len(new_image)} byte image.")
+        self._flash_app_addresses(new_start, new_end)
+
+    def _send_expecting_ack(self, packet_type, payload, timeout):
+        packet = BeeCOMPacket(packet_type=packet_type, payload=payload).create_packet()
+        self.uart_comm.send_packet(packet)
+
+        response_packet, crc_received = BeeCOMPacket.parse_packet(self.uart_comm.receive_frame(timeout=timeout))
+        if not response_packet.validate_packet(crc_received, packet_type, ACK_PACKET):
+            raise ValueError("Packet validation failed.")
+
+    def _switch_baud_rate(self, requested):
+        """Move the link to a faster rate for this session (0 asks for the fastest), keep the current one on failure."""
+        previous = self.uart_comm.get_baudrate()
+        packet = BeeCOMPacket(packet_type=PacketType.setBaudRate, payload=struct.pack('>I', requested)).create_packet()
+        self.uart_comm.send_packet(packet)
+
+        response_packet, crc_received = BeeCOMPacket.parse_packet(
+            self.uart_comm.receive_frame(timeout=self._negotiation_timeout()))
+        response_packet.validate_packet(crc_received, PacketType.setBaudRate)
+
+        if len(response_packet.payload) != 5 or response_packet.payload[0] != ACK_VALUE:
+            self.log_message.emit(f"Bootloader refused baud rate {requested}, staying at {previous}.")
+            return
+
+        baud_rate = struct.unpack('>I', response_packet.payload[1:])[0]
+        self.uart_comm.set_baudrate(baud_rate)
+
+        probe_payload = struct.pack('>I', baud_rate)
+        probe = BeeCOMPacket(packet_type=PacketType.confirmBaudRate, payload=probe_payload).create_packet()
+        for _ in range(BAUD_PROBE_ATTEMPTS):
+            self.uart_comm.send_packet(probe)
+            try:
+                response_packet, crc_received = BeeCOMPacket.parse_packet(
+                    self.uart_comm.receive_frame(timeout=BAUD_PROBE_TIMEOUT))
+                response_packet.validate_packet(crc_received, PacketType.confirmBaudRate,
+                                                bytes([ACK_VALUE]) + probe_payload)
+                self.log_message.emit(f"Switched link to {baud_rate} baud.")
+                return
+            except (TimeoutError, ValueError):
+                continue
+
+        # Without a probe the bootloader falls back on its own, wait for it before talking again
+        time.sleep(BAUD_FALLBACK_DELAY)
+        self.uart_comm.set_baudrate(previous)
+        self.log_message.emit(f"Link at {baud_rate} baud failed the probe, staying at {previous}.")
+
+    def _negotiation_timeout(self):
+        """Sectors scheduled by the last flashStart are erased in the background, each one stalls the device."""
+        return NEGOTIATION_TIMEOUT + ERASE_TIMEOUT_PER_SECTOR * self.pending_erase_sectors
+
+    def _negotiate_window(self):
+        """Ask the bootloader for a transfer window and its optional features, a window of 0 means only
+        stop-and-wait is supported."""
+        payload = bytes([REQUESTED_WINDOW_SIZE])
+        packet = BeeCOMPacket(packet_type=PacketType.configureWindow, payload=payload).create_packet()
+        self.uart_comm.send_packet(packet)
+
+        response_packet, crc_received = BeeCOMPacket.parse_packet(
+            self.uart_comm.receive_frame(timeout=self._negotiation_timeout()))
+        response_packet.validate_packet(crc_received, PacketType.configureWindow)
+
+        if len(response_packet.payload) < 2 or response_packet.payload[0] != ACK_VALUE:
+            logging.info("Bootloader does not support windowed transfer, using stop-and-wait.")
+            return 0, 0
+
+        window_size = response_packet.payload[1]
+        capabilities = response_packet.payload[2] if len(response_packet.payload) > 2 else 0
+        logging.info(f"Negotiated transfer window: {window_size} packets.")
+        return window_size, capabilities
+
+    def _build_windowed_packets(self, data_blocks, capabilities):
+        """Packetize the image as (packet_type, address, body, raw_size) tuples. Long constant runs become
+        flashFill packets, and with compression every chunk that shrinks goes out as flashDataCompressed."""
+        packets = []
+        if capabilities & CAPABILITY_FILL:
+            data_blocks, fills = HexFileProcessor.split_constant_runs(data_blocks, FILL_THRESHOLD)
+            for address, length, pattern in fills:
+                packets.append((PacketType.flashFill, address, struct.pack('>IB', length, pattern), length))
+            if fills:
+                logging.info(f"Filling {sum(length for _, length, _ in fills)} bytes without sending them.")
+
+        if not capabilities & CAPABILITY_COMPRESSED_DATA:
+            for address, data in HexFileProcessor.merge_contiguous(data_blocks):
+                for chunk in HexFileProcessor.chunk_data(data, MAX_PAYLOAD_SIZE - 4):
+                    packets.append((PacketType.flashDataWindowed, address, chunk, len(chunk)))
+                    address += len(chunk)
+            return packets
+
+        raw_size = 0
+        compressed_size = 0
+        for address, raw, compressed in HexFileProcessor.compress_blocks(data_blocks, COMPRESSED_CHUNK_SIZE):
+            raw_size += len(raw)
+            body = struct.pack('>H', len(raw)) + compressed
+            if len(compressed) < len(raw) and WINDOWED_HEADER_SIZE + len(body) <= MAX_PACKET_PAYLOAD:
+                packets.append((PacketType.flashDataCompressed, address, body, len(raw)))
+                compressed_size += len(body)
+                continue
+            for chunk in HexFileProcessor.chunk_data(raw, MAX_PAYLOAD_SIZE - 4):
+                packets.append((PacketType.flashDataWindowed, address, chunk, len(chunk)))
+                compressed_size += len(chunk)
+                address += len(chunk)
+
+        if raw_size:
+            logging.info(f"Compressed image: {raw_size} -> {compressed_size} bytes.")
+        return packets
+
+    def _send_windowed(self, packets, window_size):
+        """Pipeline sequenced packets, retransmitting only the sequence numbers the device reports lost."""
+        acked = [False] * len(packets)
+        stamps = [0] * len(packets)
+        retries = [0] * len(packets)
+        stamp = 0
+        base = 0
+        next_index = 0
+        sent_bytes = 0
+
+        def transmit(index):
+            nonlocal stamp
+            packet_type, address, body, _ = packets[index]
+            payload = struct.pack('>HI', index & 0xFFFF, address) + body
+            packet = BeeCOMPacket(packet_type=packet_type, payload=payload).create_packet()
+            self.uart_comm.send_packet(packet)
+            stamp += 1
+            stamps[index] = stamp
+
+        def retransmit(index):
+            retries[index] += 1
+            if retries[index] > MAX_RETRANSMISSIONS:
+                raise ValueError(f"Packet {index} not acknowledged after {MAX_RETRANSMISSIONS} retransmissions.")
+            logging.debug(f"Retransmitting packet {index}.")
+            transmit(index)
+
+        while base < len(packets):
+            while next_index < len(packets) and next_index - base < window_size:
+                transmit(next_index)
+                next_index += 1
+
+            try:
+                response = self.uart_comm.receive_frame(timeout=WINDOW_RESPONSE_TIMEOUT)
+            except TimeoutError:
+                for index in range(base, next_index):
+                    if not acked[index]:
+                        retransmit(index)
+                continue
+
+            response_packet, crc_received = BeeCOMPacket.parse_packet(response)
+            if response_packet.packet_type == PacketType.invalidPacket:
+                # A corrupted frame, the next window report tells which sequence number it was
+                continue
+
+            if response_packet.packet_type not in (PacketType.flashDataWindowed, PacketType.flashDataCompressed,
+                                                   PacketType.flashFill):
+                raise ValueError(f"Unexpected packet type: received {response_packet.packet_type}.")
+            response_packet.validate_packet(crc_received)
+            status, device_base, mask = struct.unpack('>BHI', response_packet.payload)
+            if status != ACK_VALUE:
+                raise ValueError(f"Bootloader rejected windowed packet, window base: {device_base}.")
+
+            new_base = base + ((device_base - base) & 0xFFFF)
+            if new_base > next_index:
+                raise ValueError(f"Window base {device_base} is ahead of the transmitted packets.")
+
+            newest_stamp = 0
+            newly_acked = [index for index in range(base, new_base) if not acked[index]]
+            newly_acked += [new_base + bit for bit in range(32)
+                            if mask & (1 << bit) and new_base + bit < next_index and not acked[new_base + bit]]
+            for index in newly_acked:
+                acked[index] = True
+                sent_bytes += packets[index][3]
+                newest_stamp = max(newest_stamp, stamps[index])
+            base = new_base
+
+            # A packet sent before one that was just acknowledged has been lost on the way
+            for index in range(base, next_index):
+                if not acked[index] and stamps[index] < newest_stamp:
+                    retransmit(index)
+
+            self.update_progress.emit(sent_bytes)
+
+        return sent_bytes
+
 class EraseFirmwareThread(QThread):
     finished = pyqtSignal(bool, str)
 
-    def __init__(self, uart_comm):
+    def __init__(self, uart_comm, hex_processor=None):
         super().__init__()
         self.uart_comm = uart_comm
+        self.hex_processor = hex_processor
+        self.sector_count = 0
 
     def run(self):
         try:
@@ -117,10 +456,22 @@ class EraseFirmwareThread(QThread):
             self.finished.emit(False, f"Error erasing firmware: {str(e)}")
 
     def _erase_firmware(self):
-        erase_packet = BeeCOMPacket(packet_type=PacketType.flashStart).create_packet()
+        """Erase the sectors the loaded image covers, or the whole application region without an image."""
+        payload = b''
+        erase_start, erase_end = METADATA_SECTOR_ADDRESS, FLASH_SECTORS[-1][0] + FLASH_SECTORS[-1][1]
+        if self.hex_processor is not None:
+            image_start, image = self.hex_processor.build_image()
+            erase_start, erase_end = image_start, image_start + len(image)
+            payload = struct.pack('>II', erase_start, erase_end - 1)
+
+        # The metadata sector is erased in any case, blank sectors are skipped by the bootloader
+        sector_count = 1 + sum(1 for start, size in FLASH_SECTORS
+                               if start != METADATA_SECTOR_ADDRESS and start < erase_end and start + size > erase_start)
+        self.sector_count = sector_count
+        erase_packet = BeeCOMPacket(packet_type=PacketType.flashStart, payload=payload).create_packet()
         self.uart_comm.send_packet(erase_packet)
 
-        response = self.uart_comm.receive_packet(timeout=10)
+        response = self.uart_comm.receive_packet(timeout=ERASE_TIMEOUT_BASE + ERASE_TIMEOUT_PER_SECTOR * sector_count)
         response_packet, crc_received = BeeCOMPacket.parse_packet(response)
 
         if not response_packet.validate_packet(crc_received, PacketType.flashStart, ACK_PACKET):
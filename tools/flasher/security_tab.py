@@ -1,6 +1,7 @@
 from PyQt5.QtWidgets import (QWidget, QVBoxLayout, QHBoxLayout, QPushButton, QComboBox,
                              QLineEdit, QLabel, QMessageBox, QFileDialog, QTextEdit)
 from crypto_manager import CryptoManager
+from public_key_header import format_public_key
 import logging
 
 class SecurityTab(QWidget):
@@ -17,7 +18,7 @@ class SecurityTab(QWidget):
         key_type_layout.addWidget(self.key_type_label)
 
         self.key_type_combo = QComboBox(self)
-        self.key_type_combo.addItems(["RSA", "ECC"])
+        self.key_type_combo.addItems(["RSA", "ECC", "Ed25519"])
         key_type_layout.addWidget(self.key_type_combo)
         main_layout.addLayout(key_type_layout)
 
@@ -60,6 +61,8 @@ class SecurityTab(QWidget):
                 self.private_key, self.public_key = self.crypto_manager.generate_rsa_key_pair(password)
             elif key_type == "ECC":
                 self.private_key, self.public_key = self.crypto_manager.generate_ecc_key_pair(password)
+            elif key_type == "Ed25519":
+                self.private_key, self.public_key = self.crypto_manager.generate_ed25519_key_pair(password)
 
             self.display_public_key()
             QMessageBox.information(self, "Success", "Key pair generated successfully.")
@@ -68,10 +71,7 @@ class SecurityTab(QWidget):
             logging.error(f"Failed to generate key pair: {e}")
 
     def display_public_key(self):
-        lines = self.public_key.decode().split('\n')
-        formatted_public_key = 'constexpr char publicKey[] = \n' + \
-                            '\n'.join(f'"{line}\\n"' for line in lines if line) + ';'
-        self.public_key_display.setText(formatted_public_key)
+        self.public_key_display.setText(format_public_key(self.public_key))
 
     def save_private_key(self):
         options = QFileDialog.Options()
@@ -1,5 +1,6 @@
 import serial
 import serial.tools.list_ports
+import struct
 import time
 
 class UARTCommunication:
@@ -24,6 +25,18 @@ class UARTCommunication:
             return True
         raise ConnectionError("No active connection to disconnect.")
 
+    def get_baudrate(self):
+        if not self.ser or not self.ser.is_open:
+            raise ConnectionError("No active connection.")
+        return self.ser.baudrate
+
+    def set_baudrate(self, baudrate):
+        """Change the rate of an open port, anything received at the old rate is dropped."""
+        if not self.ser or not self.ser.is_open:
+            raise ConnectionError("No active connection.")
+        self.ser.baudrate = baudrate
+        self.ser.reset_input_buffer()
+
     def send_packet(self, packet):
         if not self.ser or not self.ser.is_open:
             raise ConnectionError("Attempted to send on a closed connection.")
@@ -41,3 +54,24 @@ class UARTCommunication:
         if not data:
             raise TimeoutError("No data received within the specified timeout.")
         return data
+
+
+    def receive_frame(self, timeout=10):
+        """Read exactly one BeeCOM frame, leaving any following frames in the receive buffer."""
+        if not self.ser or not self.ser.is_open:
+            raise ConnectionError("Attempted to receive on a closed connection.")
+
+        deadline = time.time() + timeout
+        while self._read_exact(1, deadline) != b'\xA5':
+            pass
+        header = b'\xA5' + self._read_exact(3, deadline)
+        length = struct.unpack('<H', header[2:4])[0]
+        return header + self._read_exact(length + 2, deadline)
+
+    def _read_exact(self, size, deadline):
+        data = b''
+        while len(data) < size:
+            if time.time() >= deadline:
+                raise TimeoutError("No data received within the specified timeout.")
+            data += self.ser.read(size - len(data))
+        return data
@@ -0,0 +1,146 @@
+/* Checks Ed25519::Verify against the test vectors of RFC 8032 section 7.1 and against signatures it has to
+   refuse. Built by the Makefile next to it (make ed25519_vectors), exits with 1 on the first mismatch.
+
+   The public keys, messages and signatures are the ones of the RFC. Python's cryptography package derives
+   the same keys and signatures from the secret keys of the RFC. */
+#include "Ed25519.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+struct Vector
+{
+    const char* name;
+    const char* publicKey;
+    const char* message;
+    const char* signature;
+};
+
+const Vector rfc8032[] = {
+    {"TEST 1", "d75a980182b10ab7d54bfed3c964073a0ee172f3daa62325af021a68f707511a", "",
+     "e5564300c360ac729086e2cc806e828a84877f1eb8e5d974d873e065224901555fb8821590a33bacc61e39701cf9b46bd25bf5f"
+     "0595bbe24655141438e7a100b"},
+    {"TEST 2", "3d4017c3e843895a92b70aa74d1b7ebc9c982ccf2ec4968cc0cd55f12af4660c", "72",
+     "92a009a9f0d4cab8720e820b5f642540a2b27b5416503f8fb3762223ebdb69da085ac1e43e15996e458f3613d0f11d8c387b2ea"
+     "eb4302aeeb00d291612bb0c00"},
+    {"TEST 3", "fc51cd8e6218a1a38da47ed00230f0580816ed13ba3303ac5deb911548908025", "af82",
+     "6291d657deec24024827e69c3abe01a30ce548a284743a445e3680d7db5ac3ac18ff9b538d16f290ae67f760984dc6594a7c15e"
+     "9716ed28dc027beceea1ec40a"},
+    {"TEST SHA(abc)", "ec172b93ad5e563bf4932c70e1245034c35467ef2efd4d64ebf819683467e2bf",
+     "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d442"
+     "3643ce80e2a9ac94fa54ca49f",
+     "dc2a4459e7369633a52b1bf277839a00201009a3efbf3ecb69bea2186c26b58909351fc9ac90b3ecfdfbc7c66431e0303dca179"
+     "c138ac17ad9bef1177331a704"},
+};
+
+/* Group order L, little-endian as S is encoded */
+const char* groupOrder = "edd3f55c1a631258d69cf7a2def9de1400000000000000000000000000000010";
+
+/* y = 2 has no x on the curve, so this encoding decodes to no point */
+const char* undecodablePoint = "0200000000000000000000000000000000000000000000000000000000000000";
+
+std::vector<uint8_t> FromHex(const char* hex)
+{
+    std::vector<uint8_t> bytes;
+
+    for (size_t i = 0U; hex[i] != '\0'; i += 2U)
+    {
+        bytes.push_back(static_cast<uint8_t>(std::stoul(std::string(&hex[i], 2U), nullptr, 16)));
+    }
+    return bytes;
+}
+
+const char* Name(Ed25519::RetStatus status)
+{
+    switch (status)
+    {
+        case Ed25519::RetStatus::valid:
+            return "valid";
+        case Ed25519::RetStatus::invalidKey:
+            return "invalidKey";
+        case Ed25519::RetStatus::invalidSignature:
+            return "invalidSignature";
+        default:
+            return "hashError";
+    }
+}
+
+bool Expect(const char* name, const std::vector<uint8_t>& publicKey, const std::vector<uint8_t>& message,
+            const std::vector<uint8_t>& signature, Ed25519::RetStatus expected)
+{
+    Ed25519::RetStatus status = Ed25519::Verify(publicKey.data(), message.data(), message.size(), signature.data());
+
+    std::printf("  %-44s %s\n", name, Name(status));
+    return status == expected;
+}
+
+/* S + L with a carry through all 32 bytes, still below 2^256 for the S of the vectors */
+std::vector<uint8_t> AddGroupOrder(std::vector<uint8_t> signature)
+{
+    std::vector<uint8_t> order = FromHex(groupOrder);
+    unsigned carry = 0U;
+
+    for (size_t i = 0U; i < order.size(); ++i)
+    {
+        unsigned sum = signature[Ed25519::publicKeySize + i] + order[i] + carry;
+        signature[Ed25519::publicKeySize + i] = static_cast<uint8_t>(sum);
+        carry = sum >> 8U;
+    }
+    return signature;
+}
+} // namespace
+
+int main()
+{
+    bool ok = true;
+
+    std::printf("RFC 8032 section 7.1\n");
+    for (const Vector& vector : rfc8032)
+    {
+        ok = Expect(vector.name, FromHex(vector.publicKey), FromHex(vector.message), FromHex(vector.signature),
+                    Ed25519::RetStatus::valid)
+             && ok;
+    }
+
+    std::printf("Refused\n");
+    for (const Vector& vector : rfc8032)
+    {
+        std::vector<uint8_t> publicKey = FromHex(vector.publicKey);
+        std::vector<uint8_t> message = FromHex(vector.message);
+        std::vector<uint8_t> signature = FromHex(vector.signature);
+        std::string name = vector.name;
+
+        ok = Expect((name + ", S + L (non-canonical)").c_str(), publicKey, message, AddGroupOrder(signature),
+                    Ed25519::RetStatus::invalidSignature)
+             && ok;
+
+        std::vector<uint8_t> undecodable = FromHex(undecodablePoint);
+        ok = Expect((name + ", undecodable A").c_str(), undecodable, message, signature, Ed25519::RetStatus::invalidKey)
+             && ok;
+
+        std::vector<uint8_t> badR = signature;
+        std::copy(undecodable.begin(), undecodable.end(), badR.begin());
+        ok = Expect((name + ", undecodable R").c_str(), publicKey, message, badR, Ed25519::RetStatus::invalidSignature)
+             && ok;
+
+        std::vector<uint8_t> flippedS = signature;
+        flippedS[Ed25519::publicKeySize] ^= 0x01U;
+        ok = Expect((name + ", S changed").c_str(), publicKey, message, flippedS, Ed25519::RetStatus::invalidSignature)
+             && ok;
+
+        std::vector<uint8_t> otherMessage = message;
+        otherMessage.push_back(0x00U);
+        ok = Expect((name + ", message changed").c_str(), publicKey, otherMessage, signature,
+                    Ed25519::RetStatus::invalidSignature)
+             && ok;
+    }
+
+    if (!ok)
+    {
+        std::printf("Ed25519::Verify disagrees with RFC 8032\n");
+        return 1;
+    }
+    return 0;
+}
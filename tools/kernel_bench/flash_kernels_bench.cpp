@@ -0,0 +1,150 @@
+/* Host benchmark of FlashKernels against std::memcmp and plain byte loops. The kernels are plain C++,
+   so they build for the host as they are:
+
+   g++ -O2 -std=c++17 -I../../boot/portable/STM32F407VE flash_kernels_bench.cpp \
+       ../../boot/portable/STM32F407VE/FlashKernels.cpp -o flash_kernels_bench
+
+   Host timings only show the relative cost of the loops: the host memcmp is vectorised, the newlib
+   one on the Cortex-M4 is not. Numbers for the target come from CycleCounter on the board. */
+#include "FlashKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr size_t sectorSize = 128U * 1024U;
+constexpr int repetitions = 200;
+
+/* Keeps the compiler from dropping calls whose result is not used */
+volatile size_t sink;
+
+bool ByteIsErased(const uint8_t* flash, size_t size)
+{
+    for (size_t i = 0U; i < size; ++i)
+    {
+        if (flash[i] != 0xFFU)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ByteIsFilled(const uint8_t* flash, uint8_t pattern, size_t size)
+{
+    for (size_t i = 0U; i < size; ++i)
+    {
+        if (flash[i] != pattern)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t ByteFirstDifference(const uint8_t* flash, const uint8_t* buffer, size_t size)
+{
+    for (size_t i = 0U; i < size; ++i)
+    {
+        if (flash[i] != buffer[i])
+        {
+            return i;
+        }
+    }
+    return size;
+}
+
+bool MemcmpIsErased(const uint8_t* flash, size_t size)
+{
+    /* memcmp needs a reference, the blank check gets it against a buffer of 0xFF */
+    static std::vector<uint8_t> erased(sectorSize, 0xFFU);
+    return std::memcmp(flash, erased.data(), size) == 0;
+}
+
+template <typename Function> void Measure(const char* name, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < repetitions; ++i)
+    {
+        sink = function();
+    }
+
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    double perCall = elapsed.count() / repetitions;
+    std::printf("  %-28s %9.2f us  %7.1f MB/s\n", name, perCall, sectorSize / perCall);
+}
+
+/* The results have to agree before the timings mean anything */
+bool Check(const std::vector<uint8_t>& flash, const std::vector<uint8_t>& buffer, size_t offset)
+{
+    const uint8_t* pFlash = flash.data() + offset;
+    const uint8_t* pBuffer = buffer.data();
+    size_t size = sectorSize - offset;
+
+    return (FlashKernels::IsErased(pFlash, size) == ByteIsErased(pFlash, size))
+        && (FlashKernels::IsFilled(pFlash, 0xFFU, size) == ByteIsErased(pFlash, size))
+        && (FlashKernels::IsFilled(pFlash, pFlash[0], size) == ByteIsFilled(pFlash, pFlash[0], size))
+        && (FlashKernels::FirstDifference(pFlash, pBuffer, size) == ByteFirstDifference(pFlash, pBuffer, size))
+        && (FlashKernels::Equals(pFlash, pBuffer, size) == (std::memcmp(pFlash, pBuffer, size) == 0));
+}
+} // namespace
+
+int main()
+{
+    /* One spare byte, so the flash side can be misaligned as well */
+    std::vector<uint8_t> flash(sectorSize + 1U, 0xFFU);
+    std::vector<uint8_t> buffer(sectorSize + 1U, 0xFFU);
+    bool consistent = Check(flash, buffer, 0U) && Check(flash, buffer, 1U);
+
+    /* A range programmed with a fill pattern, once intact and once with a single byte off */
+    std::fill(flash.begin(), flash.end(), 0x5AU);
+    consistent = consistent && Check(flash, buffer, 0U) && Check(flash, buffer, 1U);
+    flash[sectorSize / 2U] = 0x5BU;
+    consistent = consistent && Check(flash, buffer, 0U) && Check(flash, buffer, 1U);
+
+    for (size_t i = 0U; i < sectorSize; ++i)
+    {
+        buffer[i] = static_cast<uint8_t>(i * 31U);
+    }
+    flash = buffer;
+    consistent = consistent && Check(flash, buffer, 0U) && Check(flash, buffer, 1U);
+
+    for (size_t position : {size_t{0U}, size_t{5U}, sectorSize / 2U, sectorSize - 1U})
+    {
+        flash[position] ^= 0x10U;
+        consistent = consistent && Check(flash, buffer, 0U) && Check(flash, buffer, 1U);
+        flash[position] ^= 0x10U;
+    }
+
+    if (!consistent)
+    {
+        std::printf("FlashKernels disagree with the reference loops\n");
+        return 1;
+    }
+
+    const uint8_t* pFlash = flash.data();
+    const uint8_t* pBuffer = buffer.data();
+    std::vector<uint8_t> erased(sectorSize, 0xFFU);
+    const uint8_t* pErased = erased.data();
+
+    std::printf("Blank check of an erased %zu KB sector\n", sectorSize / 1024U);
+    Measure("FlashKernels::IsErased", [&]() { return FlashKernels::IsErased(pErased, sectorSize); });
+    Measure("std::memcmp against 0xFF", [&]() { return MemcmpIsErased(pErased, sectorSize); });
+    Measure("byte loop", [&]() { return ByteIsErased(pErased, sectorSize); });
+
+    std::printf("Compare of an equal %zu KB sector\n", sectorSize / 1024U);
+    Measure("FlashKernels::Equals", [&]() { return FlashKernels::Equals(pFlash, pBuffer, sectorSize); });
+    Measure("std::memcmp", [&]() { return std::memcmp(pFlash, pBuffer, sectorSize) == 0; });
+    Measure("byte loop", [&]() { return ByteFirstDifference(pFlash, pBuffer, sectorSize) == sectorSize; });
+
+    std::printf("Compare with a misaligned flash side\n");
+    Measure("FlashKernels::Equals", [&]() { return FlashKernels::Equals(pFlash + 1U, pBuffer + 1U, sectorSize - 1U); });
+    Measure("std::memcmp", [&]() { return std::memcmp(pFlash + 1U, pBuffer + 1U, sectorSize - 1U) == 0; });
+    Measure("byte loop",
+            [&]() { return ByteFirstDifference(pFlash + 1U, pBuffer + 1U, sectorSize - 1U) == sectorSize - 1U; });
+
+    return 0;
+}
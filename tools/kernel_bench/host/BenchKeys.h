@@ -0,0 +1,137 @@
+#pragma once
+
+/* Generated by gen_bench_keys.py, test keys only */
+#include <cstdint>
+
+#if (ECC_FIRMWARE_VALIDATION == 1)
+namespace BootConfig {
+/* SECP256R1 point, 0x04 || X || Y */
+constexpr uint8_t publicKey[] = {
+    0x04U, 0x09U, 0xFDU, 0xA2U, 0x12U, 0xFBU, 0x34U, 0xB8U, 0x23U, 0xFEU, 0x2AU, 0x98U,
+    0xDEU, 0x42U, 0x4FU, 0xD3U, 0x6FU, 0xA6U, 0x3FU, 0xF2U, 0xF3U, 0xACU, 0xB8U, 0x7BU,
+    0x00U, 0xECU, 0x4AU, 0x4DU, 0x7AU, 0x51U, 0xD7U, 0x78U, 0x7CU, 0x01U, 0xF0U, 0x2FU,
+    0xC4U, 0x04U, 0x8CU, 0x98U, 0x06U, 0x8FU, 0x33U, 0x82U, 0xEBU, 0xAEU, 0x75U, 0x7CU,
+    0xA8U, 0x84U, 0x5FU, 0xC1U, 0x04U, 0x91U, 0xDCU, 0x56U, 0x6EU, 0xB0U, 0x7BU, 0x0AU,
+    0xE7U, 0x19U, 0x92U, 0x3DU, 0x44U,
+};
+} // namespace BootConfig
+namespace BenchKeys {
+constexpr uint8_t signature[] = {
+    0x30U, 0x45U, 0x02U, 0x20U, 0x27U, 0x80U, 0xA4U, 0x00U, 0xCEU, 0xFEU, 0xAFU, 0x6AU,
+    0xB9U, 0xD4U, 0xF5U, 0xE4U, 0x21U, 0x63U, 0x84U, 0x0AU, 0x80U, 0xB7U, 0x2DU, 0x96U,
+    0xF2U, 0xAEU, 0x6FU, 0x95U, 0x69U, 0x1DU, 0xEEU, 0x0DU, 0x8BU, 0xD4U, 0x75U, 0x72U,
+    0x02U, 0x21U, 0x00U, 0xB8U, 0xDFU, 0x73U, 0x48U, 0xECU, 0x95U, 0x64U, 0x81U, 0xC5U,
+    0x3FU, 0xBDU, 0x09U, 0x43U, 0xF1U, 0x47U, 0x95U, 0x20U, 0xF5U, 0xB5U, 0xFFU, 0xB2U,
+    0xE5U, 0xEBU, 0x1AU, 0x21U, 0x4BU, 0x14U, 0xECU, 0x6EU, 0x21U, 0xB2U, 0xFBU,
+};
+} // namespace BenchKeys
+#elif (RSA_FIRMWARE_VALIDATION == 1)
+namespace BootConfig {
+/* RSA modulus, public exponent and R^2 mod N for the Montgomery multiplication, big-endian */
+constexpr uint8_t publicKeyModulus[] = {
+    0xC0U, 0x2FU, 0xD0U, 0x08U, 0x78U, 0x39U, 0xF2U, 0x6DU, 0xD1U, 0xDEU, 0x47U, 0xABU,
+    0x02U, 0xD6U, 0x9EU, 0x13U, 0xDFU, 0x0DU, 0x23U, 0xDAU, 0xCDU, 0x66U, 0x05U, 0x16U,
+    0x25U, 0xBEU, 0x2CU, 0x46U, 0xFDU, 0x51U, 0x7DU, 0xFAU, 0xFCU, 0x6DU, 0xB2U, 0xBDU,
+    0xC5U, 0xF7U, 0x41U, 0x04U, 0xD7U, 0xEEU, 0xAEU, 0xDEU, 0x26U, 0x95U, 0xDBU, 0x3AU,
+    0x8BU, 0x73U, 0x83U, 0x89U, 0x6AU, 0x25U, 0x70U, 0x5DU, 0xFDU, 0xFAU, 0x8CU, 0xB1U,
+    0x79U, 0x8AU, 0x2EU, 0x84U, 0x8DU, 0xC7U, 0xDCU, 0xBFU, 0x03U, 0x55U, 0xDDU, 0xE1U,
+    0x2EU, 0x93U, 0x60U, 0x88U, 0x4BU, 0xD0U, 0x89U, 0x2BU, 0x97U, 0x3AU, 0x36U, 0x4FU,
+    0x3CU, 0x05U, 0x50U, 0x26U, 0x44U, 0x59U, 0x6BU, 0x8DU, 0x54U, 0xC1U, 0x84U, 0x8DU,
+    0x4BU, 0x1BU, 0x02U, 0x83U, 0x26U, 0x0EU, 0xFCU, 0xDBU, 0x09U, 0x97U, 0x87U, 0x5AU,
+    0xC7U, 0x68U, 0xB7U, 0x25U, 0x9EU, 0xC2U, 0x4CU, 0x1FU, 0xD1U, 0x45U, 0xD3U, 0x58U,
+    0x1EU, 0x01U, 0x1AU, 0x69U, 0xBFU, 0x6DU, 0x99U, 0x67U, 0x14U, 0xEEU, 0x54U, 0xD9U,
+    0x04U, 0x34U, 0xD6U, 0x11U, 0x96U, 0x91U, 0x47U, 0x45U, 0x1AU, 0x48U, 0xF9U, 0xD4U,
+    0x15U, 0x82U, 0x34U, 0xEFU, 0x7DU, 0xE5U, 0xFDU, 0x69U, 0x57U, 0x4BU, 0x4AU, 0x0EU,
+    0x9DU, 0x14U, 0x82U, 0xC5U, 0xE8U, 0xB7U, 0x05U, 0x28U, 0xB6U, 0x7BU, 0x6FU, 0xF7U,
+    0x41U, 0xF2U, 0xF2U, 0xDEU, 0xA2U, 0x9DU, 0x27U, 0x47U, 0x0BU, 0x1FU, 0xD4U, 0xF2U,
+    0xC6U, 0x43U, 0x02U, 0x83U, 0x9BU, 0x05U, 0x91U, 0xA6U, 0xB1U, 0x81U, 0x72U, 0x20U,
+    0x71U, 0xBBU, 0xD8U, 0x3DU, 0x3CU, 0x60U, 0xF9U, 0xE3U, 0x58U, 0xC0U, 0x42U, 0xA4U,
+    0x40U, 0x5DU, 0xFBU, 0xF7U, 0x02U, 0x1FU, 0x81U, 0x10U, 0x78U, 0x5FU, 0x8CU, 0xAAU,
+    0x28U, 0x73U, 0x87U, 0x55U, 0xDFU, 0x54U, 0xE4U, 0x20U, 0xB6U, 0x89U, 0xE7U, 0x8CU,
+    0xF8U, 0x72U, 0xEDU, 0xE1U, 0x04U, 0xE7U, 0xE1U, 0xCCU, 0xD0U, 0x31U, 0x0CU, 0x3FU,
+    0x15U, 0x65U, 0xC6U, 0x78U, 0xE4U, 0x44U, 0x0AU, 0x06U, 0xCFU, 0x32U, 0xAFU, 0x47U,
+    0x88U, 0xADU, 0x62U, 0xFDU,
+};
+constexpr uint8_t publicKeyExponent[] = {
+    0x01U, 0x00U, 0x01U,
+};
+constexpr uint8_t publicKeyMontgomeryRR[] = {
+    0x31U, 0x5DU, 0x21U, 0x64U, 0xA3U, 0x7CU, 0xEDU, 0x5EU, 0x30U, 0x04U, 0x8CU, 0x82U,
+    0x19U, 0x25U, 0xF6U, 0xBFU, 0xB7U, 0x47U, 0x4BU, 0xBEU, 0xCFU, 0x16U, 0x63U, 0x81U,
+    0xCDU, 0xB4U, 0xE4U, 0x84U, 0xBCU, 0x85U, 0x00U, 0xC5U, 0x02U, 0xE3U, 0x6EU, 0x99U,
+    0x95U, 0x62U, 0x3BU, 0x75U, 0xEBU, 0x8AU, 0x23U, 0xA7U, 0x05U, 0x40U, 0x59U, 0xC8U,
+    0x71U, 0x89U, 0x8DU, 0x61U, 0x99U, 0xB0U, 0x31U, 0x4FU, 0xA5U, 0x4DU, 0x1BU, 0x62U,
+    0xEBU, 0x31U, 0xB2U, 0x51U, 0x09U, 0xF8U, 0x3BU, 0x7FU, 0x89U, 0x60U, 0x0BU, 0x6DU,
+    0xB0U, 0xCAU, 0x51U, 0x3CU, 0x79U, 0x6AU, 0x0BU, 0x27U, 0x71U, 0xF0U, 0xEBU, 0xC4U,
+    0x37U, 0x89U, 0x63U, 0xC5U, 0xA4U, 0x00U, 0x0BU, 0x26U, 0x7DU, 0xBCU, 0x9FU, 0x8EU,
+    0x57U, 0xB1U, 0x6DU, 0x10U, 0xE8U, 0xBEU, 0xCEU, 0x97U, 0x12U, 0xF4U, 0x7EU, 0x09U,
+    0x3AU, 0x18U, 0x20U, 0x79U, 0x50U, 0x98U, 0xEEU, 0x07U, 0xD2U, 0xD5U, 0x76U, 0x1FU,
+    0x5EU, 0x47U, 0x13U, 0x4BU, 0xB0U, 0x84U, 0xE2U, 0xEEU, 0x35U, 0xB3U, 0x14U, 0xACU,
+    0xB2U, 0x20U, 0x96U, 0xC2U, 0xD0U, 0x2FU, 0x6BU, 0x51U, 0x4FU, 0x03U, 0x63U, 0xC3U,
+    0x4FU, 0x8CU, 0x93U, 0x99U, 0xBEU, 0xC3U, 0x96U, 0x3BU, 0x88U, 0x15U, 0xDEU, 0xEFU,
+    0x97U, 0x2FU, 0x43U, 0xF0U, 0x09U, 0x81U, 0x0EU, 0x0BU, 0x12U, 0xC9U, 0x9BU, 0xC9U,
+    0xABU, 0x71U, 0x45U, 0x6AU, 0x39U, 0x30U, 0x3FU, 0x3DU, 0x55U, 0xD4U, 0x6DU, 0x62U,
+    0xD7U, 0x52U, 0x91U, 0xF7U, 0x35U, 0x04U, 0xACU, 0x97U, 0x77U, 0xDDU, 0x72U, 0x63U,
+    0x49U, 0x8FU, 0x76U, 0xCFU, 0x5BU, 0xEDU, 0xC7U, 0xE4U, 0x98U, 0xD7U, 0x06U, 0x39U,
+    0x6BU, 0xC8U, 0x79U, 0x75U, 0x0DU, 0x87U, 0x65U, 0xC3U, 0x55U, 0x15U, 0x88U, 0x30U,
+    0xC7U, 0xEBU, 0xE1U, 0x73U, 0x8AU, 0x83U, 0x53U, 0x6AU, 0x11U, 0x8DU, 0x3EU, 0x88U,
+    0x95U, 0xF0U, 0xF1U, 0x30U, 0x34U, 0x28U, 0x82U, 0x0BU, 0x02U, 0xD6U, 0x7AU, 0x28U,
+    0xB5U, 0x15U, 0xD4U, 0x08U, 0xE3U, 0x20U, 0x5EU, 0x3EU, 0xD6U, 0xADU, 0xC5U, 0x10U,
+    0xA3U, 0xB5U, 0xC2U, 0x59U,
+};
+} // namespace BootConfig
+namespace BenchKeys {
+constexpr uint8_t signature[] = {
+    0x10U, 0xEBU, 0x58U, 0xFAU, 0xE3U, 0x3EU, 0xAEU, 0x23U, 0xA4U, 0x4BU, 0xB2U, 0x92U,
+    0x4AU, 0xFCU, 0xCDU, 0x38U, 0x69U, 0x0AU, 0x34U, 0x23U, 0xA7U, 0x1CU, 0x4EU, 0x0FU,
+    0x97U, 0x98U, 0xADU, 0xF7U, 0xDBU, 0xCBU, 0x55U, 0xE0U, 0x60U, 0x2AU, 0x8EU, 0xF5U,
+    0x49U, 0xBFU, 0xB0U, 0xBBU, 0x41U, 0xD0U, 0x6AU, 0xE6U, 0x21U, 0xC7U, 0x11U, 0xBEU,
+    0x47U, 0x02U, 0x2FU, 0x9DU, 0x59U, 0x06U, 0x42U, 0x60U, 0xAEU, 0xB5U, 0xA2U, 0x47U,
+    0x1FU, 0xBAU, 0x54U, 0xA1U, 0xEEU, 0xD0U, 0x9AU, 0x9AU, 0xC6U, 0x49U, 0x09U, 0x16U,
+    0x91U, 0xDAU, 0xFAU, 0xDBU, 0xF7U, 0x4CU, 0x7BU, 0x7AU, 0x15U, 0xD1U, 0xF7U, 0x99U,
+    0x08U, 0x2AU, 0x5FU, 0xB2U, 0x87U, 0x56U, 0xB3U, 0xDCU, 0x28U, 0x5BU, 0x6FU, 0x8EU,
+    0x54U, 0x21U, 0xB0U, 0xE5U, 0x3AU, 0x2DU, 0x72U, 0x1AU, 0x41U, 0xC1U, 0x9FU, 0x67U,
+    0x8DU, 0x4CU, 0x15U, 0xF7U, 0x6DU, 0x03U, 0xDDU, 0xA9U, 0xA9U, 0x15U, 0x06U, 0xD9U,
+    0x11U, 0xCFU, 0xA9U, 0xC7U, 0xAFU, 0x4EU, 0x6FU, 0xF3U, 0xEEU, 0x10U, 0xF3U, 0xFFU,
+    0x93U, 0xECU, 0x24U, 0xCAU, 0xA2U, 0x71U, 0xA2U, 0x80U, 0x10U, 0xC1U, 0x15U, 0xCEU,
+    0x2AU, 0x6AU, 0xB7U, 0x98U, 0xC1U, 0x99U, 0x4AU, 0x9FU, 0xAAU, 0x57U, 0x93U, 0xFBU,
+    0xCDU, 0x65U, 0x17U, 0x86U, 0x9AU, 0xFDU, 0x26U, 0xC0U, 0x3BU, 0x51U, 0x04U, 0x8EU,
+    0x22U, 0x1FU, 0x53U, 0x17U, 0x21U, 0x19U, 0x44U, 0x0AU, 0x66U, 0xAEU, 0xF3U, 0xA2U,
+    0xD7U, 0x71U, 0xEBU, 0x05U, 0x54U, 0xF9U, 0x42U, 0xC9U, 0xE1U, 0x10U, 0x20U, 0xC2U,
+    0xA5U, 0xFAU, 0x4EU, 0x20U, 0x7DU, 0xB0U, 0x5CU, 0x96U, 0xCFU, 0xA7U, 0xE5U, 0x8AU,
+    0xCAU, 0xD3U, 0xFAU, 0x67U, 0x45U, 0x12U, 0x71U, 0x1BU, 0x53U, 0x9FU, 0x3FU, 0x7FU,
+    0x55U, 0xC0U, 0xD1U, 0xFCU, 0x82U, 0x30U, 0x31U, 0x08U, 0xB2U, 0xB0U, 0x66U, 0x18U,
+    0x9BU, 0xD2U, 0x58U, 0x3CU, 0xAAU, 0x10U, 0x66U, 0xBFU, 0x63U, 0x7FU, 0x60U, 0xFFU,
+    0x40U, 0x9CU, 0x7CU, 0x78U, 0xE5U, 0x86U, 0x6AU, 0x81U, 0x1DU, 0x10U, 0xB3U, 0x1DU,
+    0x71U, 0xFBU, 0x20U, 0x53U,
+};
+} // namespace BenchKeys
+#elif (ED25519_FIRMWARE_VALIDATION == 1)
+namespace BootConfig {
+/* Ed25519 key, RFC 8032 encoding */
+constexpr uint8_t publicKey[] = {
+    0x3AU, 0x38U, 0x13U, 0x71U, 0x3FU, 0xC8U, 0xE1U, 0x19U, 0xC7U, 0x74U, 0xA3U, 0xECU,
+    0xC6U, 0x40U, 0xD9U, 0xA7U, 0x60U, 0x64U, 0x90U, 0x31U, 0x1BU, 0xDAU, 0xF6U, 0x55U,
+    0x2AU, 0x36U, 0x0CU, 0x1CU, 0x92U, 0xEAU, 0x06U, 0x75U,
+};
+} // namespace BootConfig
+namespace BenchKeys {
+constexpr uint8_t signature[] = {
+    0x85U, 0x5AU, 0x4DU, 0xC3U, 0xE1U, 0xF2U, 0xEBU, 0xDBU, 0xA9U, 0x8FU, 0x1CU, 0xB3U,
+    0x96U, 0xA4U, 0xD8U, 0xFBU, 0x21U, 0xABU, 0x69U, 0xEAU, 0xF0U, 0x05U, 0xD4U, 0x31U,
+    0x2BU, 0x0FU, 0x5AU, 0x11U, 0xC6U, 0x03U, 0x68U, 0x25U, 0xDCU, 0xA0U, 0x7EU, 0xBAU,
+    0xEFU, 0x5BU, 0x21U, 0x10U, 0x69U, 0x46U, 0xFFU, 0x63U, 0xBFU, 0x2EU, 0x94U, 0xA3U,
+    0x3CU, 0xD4U, 0xE1U, 0xF9U, 0x65U, 0xE5U, 0x05U, 0x90U, 0xDFU, 0xB7U, 0x45U, 0x82U,
+    0x3AU, 0xEFU, 0x0DU, 0x0EU,
+};
+} // namespace BenchKeys
+#endif
+
+namespace BenchKeys {
+/* SHA-256 of "signature_bench", the image digest all three signatures cover */
+constexpr uint8_t digest[] = {
+    0xC2U, 0x4EU, 0x5EU, 0x31U, 0x9BU, 0x1CU, 0xFCU, 0x4CU, 0x08U, 0xECU, 0xFBU, 0x51U,
+    0x72U, 0xD7U, 0x2FU, 0x14U, 0x6EU, 0xAAU, 0xD5U, 0xC4U, 0x20U, 0x34U, 0x00U, 0x10U,
+    0xF5U, 0xD1U, 0x97U, 0xF0U, 0x33U, 0xD6U, 0x0FU, 0x06U,
+};
+} // namespace BenchKeys
@@ -0,0 +1,12 @@
+#pragma once
+
+/* Host stand-in for boot/config/BootAlgorithm.h, the Makefile selects the backend on the command line */
+#ifndef RSA_FIRMWARE_VALIDATION
+#define RSA_FIRMWARE_VALIDATION 0
+#endif
+#ifndef ECC_FIRMWARE_VALIDATION
+#define ECC_FIRMWARE_VALIDATION 0
+#endif
+#ifndef ED25519_FIRMWARE_VALIDATION
+#define ED25519_FIRMWARE_VALIDATION 0
+#endif
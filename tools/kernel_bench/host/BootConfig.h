@@ -0,0 +1,21 @@
+#pragma once
+
+/* Host stand-in for boot/config/BootConfig.h with what the signature backends use. The heap sizes are
+   the ones of the bootloader, the keys are the test keys of BenchKeys.h. */
+#include <cstddef>
+#include <cstdint>
+#include "BootAlgorithm.h"
+
+namespace BootConfig {
+#define IMAGE_DIGEST_BLAKE2S 0
+
+constexpr size_t maxDecompressedSize = 2048U;
+/* make sweep raises the heap, so settings that need more than the bootloader gives still report their use */
+#ifndef BENCH_CRYPTO_HEAP_SIZE
+#define BENCH_CRYPTO_HEAP_SIZE 8192U
+#endif
+constexpr size_t cryptoHeapSize = (ED25519_FIRMWARE_VALIDATION == 1) ? 0U : BENCH_CRYPTO_HEAP_SIZE;
+constexpr size_t arenaSize = (cryptoHeapSize > maxDecompressedSize) ? cryptoHeapSize : maxDecompressedSize;
+} // namespace BootConfig
+
+#include "BenchKeys.h"
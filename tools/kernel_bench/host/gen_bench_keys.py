@@ -0,0 +1,59 @@
+"""Writes BenchKeys.h, a test key and a signature of a fixed digest for every backend of signature_bench.
+
+The public keys come out in the BootConfig.h form of tools/flasher/public_key_header.py, so the bench
+takes them the way the bootloader does. The private keys are thrown away.
+"""
+import hashlib
+import os
+import sys
+
+from cryptography.hazmat.primitives import hashes, serialization
+from cryptography.hazmat.primitives.asymmetric import ec, ed25519, padding, rsa, utils
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..', '..', 'flasher'))
+from public_key_header import format_public_key, _format_array  # noqa: E402
+
+DIGEST = hashlib.sha256(b'signature_bench').digest()
+
+
+def _pem(private_key):
+    return private_key.public_key().public_bytes(serialization.Encoding.PEM,
+                                                 serialization.PublicFormat.SubjectPublicKeyInfo)
+
+
+def main():
+    ecc_key = ec.generate_private_key(ec.SECP256R1())
+    ecc_signature = ecc_key.sign(DIGEST, ec.ECDSA(utils.Prehashed(hashes.SHA256())))
+
+    rsa_key = rsa.generate_private_key(public_exponent=65537, key_size=2048)
+    rsa_signature = rsa_key.sign(DIGEST, padding.PSS(mgf=padding.MGF1(hashes.SHA256()), salt_length=32),
+                                 utils.Prehashed(hashes.SHA256()))
+
+    ed25519_key = ed25519.Ed25519PrivateKey.generate()
+    ed25519_signature = ed25519_key.sign(DIGEST)
+
+    backends = [('ECC', ecc_key, ecc_signature), ('RSA', rsa_key, rsa_signature),
+                ('ED25519', ed25519_key, ed25519_signature)]
+
+    lines = ['#pragma once', '', '/* Generated by gen_bench_keys.py, test keys only */', '#include <cstdint>', '']
+    for index, (name, key, signature) in enumerate(backends):
+        lines.append(('#if' if index == 0 else '#elif') + f' ({name}_FIRMWARE_VALIDATION == 1)')
+        lines.append('namespace BootConfig {')
+        lines.append(format_public_key(_pem(key)))
+        lines.append('} // namespace BootConfig')
+        lines.append('namespace BenchKeys {')
+        lines.append(_format_array('signature', signature))
+        lines.append('} // namespace BenchKeys')
+    lines.append('#endif')
+    lines.append('')
+    lines.append('namespace BenchKeys {')
+    lines.append('/* SHA-256 of "signature_bench", the image digest all three signatures cover */')
+    lines.append(_format_array('digest', DIGEST))
+    lines.append('} // namespace BenchKeys')
+
+    with open(os.path.join(os.path.dirname(__file__), 'BenchKeys.h'), 'w') as header:
+        header.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,6 @@
+#pragma once
+
+/* Host stand-in for the parts of the HAL the benchmarked boot sources use */
+#include <cstdint>
+
+#define __REV(x) __builtin_bswap32(x)
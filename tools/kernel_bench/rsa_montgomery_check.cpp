@@ -0,0 +1,145 @@
+/* Checks the R^2 mod N that SecureBootRSA puts into the RN cache of mbedtls, and times the verify with and
+   without it. `make` in this directory builds and runs it against the RSA key of host/BenchKeys.h,
+   which public_key_header.py generated the same way as the BootConfig.h constants of a real key.
+
+   The reference is the value mbedtls itself stores in RN: mbedtls_mpi_exp_mod() computes R^2 mod N
+   into an empty cache on its first call, the public operation of mbedtls_rsa_pkcs1_verify() goes
+   through it with ctx->RN. */
+#include "BootArena.h"
+#include "BootConfig.h"
+#include "SecureBootRSA.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+constexpr int repetitions = 50;
+
+/* The same as SecureBootRSA::ValidateHash without the precomputed R^2 mod N */
+SecureBoot::RetStatus ValidateWithoutCache(const unsigned char* signature, size_t sig_len, const unsigned char* hash)
+{
+    SecureBoot::RetStatus status = SecureBoot::RetStatus::valid;
+    mbedtls_rsa_context rsaCtx;
+    mbedtls_rsa_init(&rsaCtx);
+
+    if ((mbedtls_rsa_import_raw(&rsaCtx, BootConfig::publicKeyModulus, sizeof(BootConfig::publicKeyModulus), nullptr,
+                                0U, nullptr, 0U, nullptr, 0U, BootConfig::publicKeyExponent,
+                                sizeof(BootConfig::publicKeyExponent))
+         != 0)
+        || (mbedtls_rsa_complete(&rsaCtx) != 0))
+    {
+        status = SecureBoot::RetStatus::publicKeyError;
+    }
+    else if (mbedtls_rsa_set_padding(&rsaCtx, MBEDTLS_RSA_PKCS_V21, MBEDTLS_MD_SHA256) != 0)
+    {
+        status = SecureBoot::RetStatus::paddingError;
+    }
+    else if ((sig_len != mbedtls_rsa_get_len(&rsaCtx))
+             || (mbedtls_rsa_pkcs1_verify(&rsaCtx, MBEDTLS_MD_SHA256, SecureBoot::hashSize, hash, signature) != 0))
+    {
+        status = SecureBoot::RetStatus::invalidSignature;
+    }
+
+    mbedtls_rsa_free(&rsaCtx);
+    return status;
+}
+
+/* R^2 mod N as mbedtls caches it after the first exponentiation, compared with BootConfig */
+bool CheckMontgomeryRR()
+{
+    mbedtls_mpi n, e, x, rr, expected;
+    mbedtls_mpi_init(&n);
+    mbedtls_mpi_init(&e);
+    mbedtls_mpi_init(&x);
+    mbedtls_mpi_init(&rr);
+    mbedtls_mpi_init(&expected);
+
+    bool ok = (mbedtls_mpi_read_binary(&n, BootConfig::publicKeyModulus, sizeof(BootConfig::publicKeyModulus)) == 0)
+              && (mbedtls_mpi_read_binary(&e, BootConfig::publicKeyExponent, sizeof(BootConfig::publicKeyExponent))
+                  == 0)
+              && (mbedtls_mpi_lset(&x, 2) == 0) && (mbedtls_mpi_exp_mod(&x, &x, &e, &n, &rr) == 0)
+              && (mbedtls_mpi_read_binary(&expected, BootConfig::publicKeyMontgomeryRR,
+                                          sizeof(BootConfig::publicKeyMontgomeryRR))
+                  == 0)
+              && (mbedtls_mpi_cmp_mpi(&rr, &expected) == 0);
+
+    mbedtls_mpi_free(&expected);
+    mbedtls_mpi_free(&rr);
+    mbedtls_mpi_free(&x);
+    mbedtls_mpi_free(&e);
+    mbedtls_mpi_free(&n);
+    return ok;
+}
+
+uint64_t Now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+/* Best of all runs, each in a verify scope with the heap of the bootloader */
+template <typename Function> uint64_t Measure(Function function)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int i = 0; i < repetitions; ++i)
+    {
+        BootArena::Scope scope(BootArena::Phase::verify);
+        SecureBootRSA secureBoot;
+
+        uint64_t start = Now();
+        SecureBoot::RetStatus status = function(secureBoot);
+        uint64_t elapsed = Now() - start;
+        best = ((status == SecureBoot::RetStatus::valid) && (elapsed < best)) ? elapsed : best;
+    }
+    return best;
+}
+} // namespace
+
+int main()
+{
+    bool ok;
+    {
+        /* The mpi functions allocate from the mbedtls heap as well */
+        BootArena::Scope scope(BootArena::Phase::verify);
+        SecureBootRSA secureBoot;
+        ok = CheckMontgomeryRR();
+    }
+
+    if (!ok)
+    {
+        std::printf("publicKeyMontgomeryRR differs from the R^2 mod N of mbedtls\n");
+        return 1;
+    }
+
+    uint64_t cached = Measure([](SecureBootRSA& secureBoot) {
+        return secureBoot.ValidateHash(BenchKeys::signature, sizeof(BenchKeys::signature), BenchKeys::digest);
+    });
+    uint64_t uncached = Measure([](SecureBootRSA&) {
+        return ValidateWithoutCache(BenchKeys::signature, sizeof(BenchKeys::signature), BenchKeys::digest);
+    });
+
+    if ((cached == UINT64_MAX) || (uncached == UINT64_MAX))
+    {
+        std::printf("the test signature does not verify\n");
+        return 1;
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    const char* unit = "cycles/verify";
+#else
+    const char* unit = "ns/verify";
+#endif
+    std::printf("publicKeyMontgomeryRR matches mbedtls\n");
+    std::printf("  %-28s %12llu %s\n", "RSA-2048 PSS, RN precomputed", static_cast<unsigned long long>(cached), unit);
+    std::printf("  %-28s %12llu %s\n", "RSA-2048 PSS, RN computed", static_cast<unsigned long long>(uncached), unit);
+    return 0;
+}
@@ -0,0 +1,208 @@
+/* Host benchmark of the SHA-256 compression in Sha256Process.cpp against the portable C one of mbedtls.
+   The boot one is renamed so both end up in the same program, mbedtls is built with its default
+   configuration:
+
+   M=../../ext/mbedtls
+   gcc -O2 -c -I$M/include $M/library/sha256.c $M/library/platform_util.c
+   g++ -O2 -std=c++17 -DMBEDTLS_SHA256_PROCESS_ALT -Dmbedtls_internal_sha256_process=boot_sha256_process \
+       -Ihost -I$M/include sha256_bench.cpp ../../boot/portable/STM32F407VE/Sha256Process.cpp \
+       sha256.o platform_util.o -o sha256_bench
+
+   Checks the FIPS 180-4 example messages and multi-block input of many lengths and alignments against
+   mbedtls_sha256(), then reports cycles per byte (time stamp counter on x86, ns per byte elsewhere). The
+   host compiler schedules both differently than arm-none-eabi-gcc, numbers for the target come from
+   CycleCounter on the board. */
+extern "C"
+{
+#include "mbedtls/sha256.h"
+}
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+constexpr size_t blockSize = 64U;
+constexpr size_t digestSize = 32U;
+constexpr size_t benchSize = 256U * 1024U;
+constexpr int repetitions = 50;
+
+volatile uint8_t sink;
+
+/* Whole message through the boot compression, padding as in FIPS 180-4 5.1.1 */
+void BootSha256(const uint8_t* data, size_t size, uint8_t* digest)
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    size_t offset = 0U;
+    for (; size - offset >= blockSize; offset += blockSize)
+    {
+        boot_sha256_process(&ctx, &data[offset]);
+    }
+
+    uint8_t tail[2U * blockSize] = {};
+    size_t rest = size - offset;
+    std::memcpy(tail, &data[offset], rest);
+    tail[rest] = 0x80U;
+    size_t tailSize = (rest < blockSize - sizeof(uint64_t)) ? blockSize : 2U * blockSize;
+    uint64_t bits = static_cast<uint64_t>(size) * 8U;
+    for (size_t i = 0U; i < sizeof(bits); ++i)
+    {
+        tail[tailSize - 1U - i] = static_cast<uint8_t>(bits >> (8U * i));
+    }
+    for (size_t i = 0U; i < tailSize; i += blockSize)
+    {
+        boot_sha256_process(&ctx, &tail[i]);
+    }
+
+    const uint32_t* state = ctx.MBEDTLS_PRIVATE(state);
+    for (size_t i = 0U; i < digestSize / sizeof(uint32_t); ++i)
+    {
+        digest[4U * i] = static_cast<uint8_t>(state[i] >> 24U);
+        digest[4U * i + 1U] = static_cast<uint8_t>(state[i] >> 16U);
+        digest[4U * i + 2U] = static_cast<uint8_t>(state[i] >> 8U);
+        digest[4U * i + 3U] = static_cast<uint8_t>(state[i]);
+    }
+    mbedtls_sha256_free(&ctx);
+}
+
+void ReferenceSha256(const uint8_t* data, size_t size, uint8_t* digest)
+{
+    mbedtls_sha256(data, size, digest, 0);
+}
+
+std::string Hex(const uint8_t* data, size_t size)
+{
+    std::string hex;
+    char digit[3];
+
+    for (size_t i = 0U; i < size; ++i)
+    {
+        std::snprintf(digit, sizeof(digit), "%02x", data[i]);
+        hex += digit;
+    }
+    return hex;
+}
+
+/* FIPS 180-4 example messages, one block, two blocks and one million times 'a' */
+bool CheckVectors()
+{
+    struct Vector
+    {
+        std::string message;
+        const char* digest;
+    };
+    const Vector vectors[] = {
+        {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+        {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+        {std::string(1000000U, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    };
+    bool ok = true;
+
+    for (const Vector& vector : vectors)
+    {
+        uint8_t digest[digestSize];
+        BootSha256(reinterpret_cast<const uint8_t*>(vector.message.data()), vector.message.size(), digest);
+        if (Hex(digest, digestSize) != vector.digest)
+        {
+            std::printf("FIPS 180-4 vector of %zu bytes fails: %s\n", vector.message.size(),
+                        Hex(digest, digestSize).c_str());
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/* Every length around the padding boundaries and some multi-block ones, from aligned and odd addresses */
+bool CheckAgainstMbedtls(const std::vector<uint8_t>& data)
+{
+    std::vector<size_t> sizes;
+    for (size_t size = 0U; size <= 4U * blockSize; ++size)
+    {
+        sizes.push_back(size);
+    }
+    for (size_t size : {size_t{1000U}, size_t{4096U}, size_t{16383U}, size_t{65536U}, benchSize - 1U})
+    {
+        sizes.push_back(size);
+    }
+
+    for (size_t offset : {size_t{0U}, size_t{1U}, size_t{3U}})
+    {
+        for (size_t size : sizes)
+        {
+            uint8_t boot[digestSize];
+            uint8_t reference[digestSize];
+            BootSha256(&data[offset], size, boot);
+            ReferenceSha256(&data[offset], size, reference);
+            if (std::memcmp(boot, reference, digestSize) != 0)
+            {
+                std::printf("%zu bytes at offset %zu differ from mbedtls\n", size, offset);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+uint64_t Now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+}
+
+template <typename Function> void Measure(const char* name, const uint8_t* data, Function function)
+{
+    uint8_t digest[digestSize];
+    uint64_t best = UINT64_MAX;
+
+    /* Best of all runs, the others are disturbed by the host */
+    for (int i = 0; i < repetitions; ++i)
+    {
+        uint64_t start = Now();
+        function(data, benchSize, digest);
+        uint64_t elapsed = Now() - start;
+        best = (elapsed < best) ? elapsed : best;
+        sink = digest[0];
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    std::printf("  %-30s %6.2f cycles/byte\n", name, static_cast<double>(best) / benchSize);
+#else
+    std::printf("  %-30s %6.2f ns/byte\n", name, static_cast<double>(best) / benchSize);
+#endif
+}
+} // namespace
+
+int main()
+{
+    /* Spare bytes for the misaligned starts */
+    std::vector<uint8_t> data(benchSize + 3U);
+    for (size_t i = 0U; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>((i * 2654435761U) >> 13U);
+    }
+
+    if (!CheckVectors() || !CheckAgainstMbedtls(data))
+    {
+        return 1;
+    }
+
+    std::printf("SHA-256 of %zu KB\n", benchSize / 1024U);
+    Measure("Sha256Process.cpp", data.data(), BootSha256);
+    Measure("mbedtls portable C", data.data(), ReferenceSha256);
+
+    return 0;
+}